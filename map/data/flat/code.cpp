@@ -0,0 +1,172 @@
+#include <cstdio>
+#include <iostream>
+
+#include "flat_map.hpp"
+#include "flat_set.hpp"
+#include "map.hpp"
+
+long long aa = 13131, bb = 5353, MOD = (long long)(1e9 + 7), now = 1;
+int rand() {
+    for (int i = 1; i < 3; i++) now = (now * aa + bb) % MOD;
+    return now;
+}
+
+class Data {
+   public:
+    int *x;
+    Data() : x(new int(1)) {
+    }
+    Data(int p) : x(new int(p)) {
+    }
+    Data(const Data &other) : x(new int(*(other.x))) {
+    }
+    ~Data() {
+        delete x;
+    }
+    Data &operator=(const Data &other) {
+        if (this == &other) return *this;
+        *x = *(other.x);
+        return *this;
+    }
+    int num() const {
+        return *x;
+    }
+};
+
+struct cmp {
+    bool operator()(const int &a, const int &b) const {
+        return a > b;
+    }
+};
+
+bool same(sjtu::flat_map<int, Data, cmp> &flat, sjtu::map<int, Data, cmp> &tree) {
+    if (flat.size() != tree.size()) return false;
+    sjtu::flat_map<int, Data, cmp>::iterator it = flat.begin();
+    for (sjtu::map<int, Data, cmp>::iterator jt = tree.begin(); jt != tree.end();
+         ++jt, ++it) {
+        if (it->first != jt->first) return false;
+        if (it->second.num() != jt->second.num()) return false;
+    }
+    return it == flat.end();
+}
+
+void test_random() {
+    puts("Test: random operations against sjtu::map");
+    sjtu::flat_map<int, Data, cmp> flat;
+    sjtu::map<int, Data, cmp> tree;
+    for (int i = 0; i < 20000; i++) {
+        int op = rand() % 4, key = rand() % 3000, value = rand();
+        if (op == 0) {
+            flat[key] = Data(value);
+            tree[key] = Data(value);
+        } else if (op == 1) {
+            sjtu::pair<const int, Data> entry(key, Data(value));
+            bool a = flat.insert(entry).second;
+            bool b = tree.insert(entry).second;
+            if (a != b) puts("insert mismatch");
+        } else if (op == 2) {
+            if (flat.count(key) != tree.count(key)) puts("count mismatch");
+            if (flat.count(key)) {
+                flat.erase(flat.find(key));
+                tree.erase(tree.find(key));
+            }
+        } else {
+            try {
+                int a = flat.at(key).num();
+                if (a != tree.at(key).num()) puts("at mismatch");
+            } catch (sjtu::index_out_of_bound &) {
+                if (tree.count(key)) puts("at threw");
+            }
+        }
+    }
+    std::cout << "size:" << flat.size() << " same:" << same(flat, tree)
+              << std::endl;
+}
+
+void test_bulk() {
+    puts("Test: bulk insert");
+    sjtu::flat_map<int, Data, cmp> flat;
+    sjtu::map<int, Data, cmp> tree;
+    for (int round = 0; round < 20; round++) {
+        sjtu::map<int, Data> batch;
+        for (int i = 0; i < 500; i++) {
+            int key = rand() % 20000;
+            batch[key] = Data(rand());
+        }
+        flat.insert(batch.cbegin(), batch.cend());
+        for (sjtu::map<int, Data>::const_iterator it = batch.cbegin();
+             it != batch.cend(); ++it) {
+            tree.insert(*it);
+        }
+        if (!same(flat, tree)) puts("bulk mismatch");
+    }
+    std::cout << "size:" << flat.size() << " same:" << same(flat, tree)
+              << std::endl;
+
+    sjtu::pair<const int, Data> dup[3] = {sjtu::pair<const int, Data>(7, 1),
+                                          sjtu::pair<const int, Data>(7, 2),
+                                          sjtu::pair<const int, Data>(8, 3)};
+    sjtu::flat_map<int, Data> small;
+    small.insert(dup, dup + 3);
+    std::cout << small.size() << ' ' << small.at(7).num() << ' '
+              << small.at(8).num() << std::endl;
+}
+
+void test_iterator() {
+    puts("Test: iterator");
+    sjtu::flat_map<int, Data> flat;
+    for (int i = 0; i < 10; i++) flat[i * 3] = Data(i);
+    const sjtu::flat_map<int, Data> copy(flat);
+    long long sum = 0;
+    for (sjtu::flat_map<int, Data>::const_iterator it = copy.cbegin();
+         it != copy.cend(); ++it) {
+        sum += it->first * (*it).second.num();
+    }
+    std::cout << sum << std::endl;
+    sjtu::flat_map<int, Data>::iterator it = flat.end();
+    --it;
+    it->second = Data(100);
+    std::cout << it->first << ' ' << flat.at(27).num() << std::endl;
+    try {
+        ++flat.end();
+    } catch (sjtu::invalid_iterator &) {
+        puts("++end() throws");
+    }
+    try {
+        --flat.begin();
+    } catch (sjtu::invalid_iterator &) {
+        puts("--begin() throws");
+    }
+    try {
+        copy[1];
+    } catch (sjtu::index_out_of_bound &) {
+        puts("const [] throws");
+    }
+}
+
+void test_set() {
+    puts("Test: flat_set");
+    sjtu::flat_set<int> set;
+    int values[1000];
+    for (int i = 0; i < 1000; i++) values[i] = rand() % 700;
+    set.insert(values, values + 500);
+    for (int i = 500; i < 1000; i++) set.insert(values[i]);
+    int previous = -1;
+    bool sorted = true;
+    for (sjtu::flat_set<int>::iterator it = set.begin(); it != set.end();
+         ++it) {
+        if (*it <= previous) sorted = false;
+        previous = *it;
+    }
+    set.erase(set.find(values[0]));
+    std::cout << "size:" << set.size() << " sorted:" << sorted
+              << " count:" << set.count(values[0]) << std::endl;
+}
+
+int main() {
+    test_random();
+    test_bulk();
+    test_iterator();
+    test_set();
+    return 0;
+}
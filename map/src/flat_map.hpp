@@ -0,0 +1,484 @@
+/**
+ * implement a container like std::flat_map
+ */
+#ifndef SJTU_FLAT_MAP_HPP
+#define SJTU_FLAT_MAP_HPP
+
+// only for std::less<T>
+#include <cstddef>
+#include <functional>
+
+#include "exceptions.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+
+namespace sjtu {
+
+namespace flat_detail {
+
+/**
+ * first position in keys[0, n) whose key is not less than key.
+ * the loop body has no data-dependent branch, so the compiler can lower the
+ * choice to a conditional move and the pipeline never mispredicts.
+ */
+template <class Key, class Compare>
+size_t lower_bound(const Key *keys, size_t n, const Key &key) {
+    if (n == 0) return 0;
+    const Key *base = keys;
+    while (n > 1) {
+        size_t half = n / 2;
+        base = Compare()(base[half], key) ? base + half : base;
+        n -= half;
+    }
+    return (base - keys) + Compare()(*base, key);
+}
+
+/**
+ * stable bottom-up merge sort of the indices [0, n) by keys[index].
+ * buf must have room for n indices.
+ */
+template <class Key, class Compare>
+void sort_index(const Key *keys, size_t *order, size_t *buf, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+    size_t *src = order;
+    size_t *dst = buf;
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t a = lo, b = mid, k = lo;
+            while (a < mid && b < hi) {
+                dst[k++] = Compare()(keys[src[b]], keys[src[a]]) ? src[b++]
+                                                                 : src[a++];
+            }
+            while (a < mid) dst[k++] = src[a++];
+            while (b < hi) dst[k++] = src[b++];
+        }
+        std::swap(src, dst);
+    }
+    if (src != order) {
+        for (size_t i = 0; i < n; ++i) {
+            order[i] = src[i];
+        }
+    }
+}
+
+/**
+ * plan a bulk insertion of staged[0, m) into the sorted existing[0, n).
+ * order and pos must have room for m entries, buf for another m.
+ * on return order[0, u) lists the staged indices to insert in key order (the
+ * first occurrence of each key wins, keys already present are dropped) and
+ * pos[j] is the slot in existing in front of which order[j] belongs.
+ * nothing is modified, so a throwing Compare leaves the container intact.
+ */
+template <class Key, class Compare>
+size_t plan_insert(const Key *existing, size_t n, const Key *staged, size_t m,
+                   size_t *order, size_t *buf, size_t *pos) {
+    sort_index<Key, Compare>(staged, order, buf, m);
+    size_t unique = 0;
+    for (size_t i = 0; i < m; ++i) {
+        const Key &key = staged[order[i]];
+        if (unique > 0 && !Compare()(staged[order[unique - 1]], key)) {
+            continue;
+        }
+        size_t p = lower_bound<Key, Compare>(existing, n, key);
+        if (p < n && !Compare()(key, existing[p])) continue;
+        pos[unique] = p;
+        order[unique++] = order[i];
+    }
+    return unique;
+}
+
+/**
+ * lets iterators that yield a proxy by value support it->first.
+ */
+template <class Ref>
+struct arrow_proxy {
+    Ref ref;
+    Ref *operator->() {
+        return &ref;
+    }
+};
+
+}  // namespace flat_detail
+
+/**
+ * a sorted associative container with the interface of sjtu::map.
+ * keys and values live in two sorted sjtu::vector columns, so a lookup is a
+ * binary search over contiguous keys and there is no per-entry node overhead.
+ * insertion and erasure are O(n); prefer the bulk insert(first, last) when
+ * loading many entries at once.
+ */
+template <class Key, class T, class Compare = std::less<Key> >
+class flat_map {
+   public:
+    typedef pair<const Key, T> value_type;
+    /**
+     * what iterators yield: a pair of references into the two columns.
+     */
+    typedef pair<const Key &, T &> reference;
+    typedef pair<const Key &, const T &> const_reference;
+
+   private:
+    vector<Key> keys;
+    vector<T> values;
+
+    size_t find_index(const Key &key) const {
+        size_t n = keys.size();
+        size_t p = flat_detail::lower_bound<Key, Compare>(keys.data(), n, key);
+        if (p < n && !Compare()(key, keys.data()[p])) return p;
+        return n;
+    }
+
+   public:
+    class const_iterator;
+    class iterator {
+       private:
+        flat_map *map_ptr;
+        size_t index;
+        friend class flat_map;
+
+       public:
+        iterator() : map_ptr(nullptr), index(0) {
+        }
+
+        iterator(flat_map *map_ptr, size_t index)
+            : map_ptr(map_ptr), index(index) {
+        }
+
+        iterator operator++(int) {
+            iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        iterator &operator++() {
+            if (map_ptr == nullptr || index >= map_ptr->size()) {
+                throw invalid_iterator();
+            }
+            ++index;
+            return *this;
+        }
+
+        iterator operator--(int) {
+            iterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        iterator &operator--() {
+            if (map_ptr == nullptr || index == 0) {
+                throw invalid_iterator();
+            }
+            --index;
+            return *this;
+        }
+
+        reference operator*() const {
+            if (map_ptr == nullptr || index >= map_ptr->size()) {
+                throw invalid_iterator();
+            }
+            const Key &key = map_ptr->keys.data()[index];
+            return reference(key, map_ptr->values.data()[index]);
+        }
+
+        flat_detail::arrow_proxy<reference> operator->() const {
+            return flat_detail::arrow_proxy<reference>{**this};
+        }
+
+        bool operator==(const iterator &rhs) const {
+            return (index == rhs.index) && (map_ptr == rhs.map_ptr);
+        }
+
+        bool operator==(const const_iterator &rhs) const {
+            return (index == rhs.index) && (map_ptr == rhs.map_ptr);
+        }
+
+        bool operator!=(const iterator &rhs) const {
+            return !(*this == rhs);
+        }
+
+        bool operator!=(const const_iterator &rhs) const {
+            return !(*this == rhs);
+        }
+    };
+
+    class const_iterator {
+       private:
+        const flat_map *map_ptr;
+        size_t index;
+        friend class flat_map;
+
+       public:
+        const_iterator() : map_ptr(nullptr), index(0) {
+        }
+
+        const_iterator(const flat_map *map_ptr, size_t index)
+            : map_ptr(map_ptr), index(index) {
+        }
+
+        const_iterator(const iterator &other)
+            : map_ptr(other.map_ptr), index(other.index) {
+        }
+
+        const_iterator operator++(int) {
+            const_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        const_iterator &operator++() {
+            if (map_ptr == nullptr || index >= map_ptr->size()) {
+                throw invalid_iterator();
+            }
+            ++index;
+            return *this;
+        }
+
+        const_iterator operator--(int) {
+            const_iterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        const_iterator &operator--() {
+            if (map_ptr == nullptr || index == 0) {
+                throw invalid_iterator();
+            }
+            --index;
+            return *this;
+        }
+
+        const_reference operator*() const {
+            if (map_ptr == nullptr || index >= map_ptr->size()) {
+                throw invalid_iterator();
+            }
+            return const_reference(map_ptr->keys.data()[index],
+                                   map_ptr->values.data()[index]);
+        }
+
+        flat_detail::arrow_proxy<const_reference> operator->() const {
+            return flat_detail::arrow_proxy<const_reference>{**this};
+        }
+
+        bool operator==(const const_iterator &rhs) const {
+            return (index == rhs.index) && (map_ptr == rhs.map_ptr);
+        }
+
+        bool operator==(const iterator &rhs) const {
+            return (index == rhs.index) && (map_ptr == rhs.map_ptr);
+        }
+
+        bool operator!=(const const_iterator &rhs) const {
+            return !(*this == rhs);
+        }
+
+        bool operator!=(const iterator &rhs) const {
+            return !(*this == rhs);
+        }
+    };
+
+    flat_map() {
+    }
+
+    flat_map(const flat_map &other) : keys(other.keys), values(other.values) {
+    }
+
+    flat_map &operator=(const flat_map &other) {
+        if (this != &other) {
+            keys = other.keys;
+            values = other.values;
+        }
+        return *this;
+    }
+
+    ~flat_map() {
+    }
+
+    /**
+     * access specified element with bounds checking
+     * throw index_out_of_bound if no such key exists.
+     */
+    T &at(const Key &key) {
+        size_t p = find_index(key);
+        if (p == keys.size()) {
+            throw index_out_of_bound();
+        }
+        return values.data()[p];
+    }
+
+    const T &at(const Key &key) const {
+        size_t p = find_index(key);
+        if (p == keys.size()) {
+            throw index_out_of_bound();
+        }
+        return values.data()[p];
+    }
+
+    /**
+     * access specified element, inserting T() if the key does not exist.
+     */
+    T &operator[](const Key &key) {
+        size_t n = keys.size();
+        size_t p = flat_detail::lower_bound<Key, Compare>(keys.data(), n, key);
+        if (p == n || Compare()(key, keys.data()[p])) {
+            keys.insert(p, key);
+            try {
+                values.insert(p, T());
+            } catch (...) {
+                keys.erase(p);
+                throw;
+            }
+        }
+        return values.data()[p];
+    }
+
+    /**
+     * behave like at() throw index_out_of_bound if such key does not exist.
+     */
+    const T &operator[](const Key &key) const {
+        return at(key);
+    }
+
+    iterator begin() {
+        return iterator(this, 0);
+    }
+
+    const_iterator cbegin() const {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() {
+        return iterator(this, keys.size());
+    }
+
+    const_iterator cend() const {
+        return const_iterator(this, keys.size());
+    }
+
+    bool empty() const {
+        return keys.empty();
+    }
+
+    size_t size() const {
+        return keys.size();
+    }
+
+    void clear() {
+        keys.clear();
+        values.clear();
+    }
+
+    /**
+     * insert an element.
+     * return a pair, the first of the pair is
+     *   the iterator to the new element (or the element that prevented the
+     * insertion), the second one is true if insert successfully, or false.
+     */
+    pair<iterator, bool> insert(const value_type &value) {
+        size_t n = keys.size();
+        size_t p =
+            flat_detail::lower_bound<Key, Compare>(keys.data(), n, value.first);
+        if (p < n && !Compare()(value.first, keys.data()[p])) {
+            return pair<iterator, bool>(iterator(this, p), false);
+        }
+        keys.insert(p, value.first);
+        try {
+            values.insert(p, value.second);
+        } catch (...) {
+            keys.erase(p);
+            throw;
+        }
+        return pair<iterator, bool>(iterator(this, p), true);
+    }
+
+    /**
+     * insert every element of [first, last) whose key is not present yet.
+     * the batch is sorted once and merged into place in O(n + m log m)
+     * instead of paying an O(n) shift per element. if several elements of
+     * the batch share a key, the first one wins. if Compare throws, the map
+     * is left unchanged.
+     */
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+        vector<Key> staged_keys;
+        vector<T> staged_values;
+        for (; first != last; ++first) {
+            staged_keys.push_back((*first).first);
+            staged_values.push_back((*first).second);
+        }
+        size_t m = staged_keys.size();
+        if (m == 0) return;
+
+        size_t n = keys.size();
+        size_t *order = new size_t[3 * m];
+        size_t *pos = order + 2 * m;
+        size_t unique;
+        try {
+            unique = flat_detail::plan_insert<Key, Compare>(
+                keys.data(), n, staged_keys.data(), m, order, order + m, pos);
+            // grow both columns; the new tail slots are overwritten below
+            for (size_t j = 0; j < unique; ++j) {
+                keys.push_back(staged_keys.data()[order[j]]);
+                values.push_back(staged_values.data()[order[j]]);
+            }
+        } catch (...) {
+            while (values.size() > n) values.pop_back();
+            while (keys.size() > n) keys.pop_back();
+            delete[] order;
+            throw;
+        }
+
+        // walk backwards, shifting each run of old entries up by the number
+        // of new entries that sort in front of it; no comparison is needed
+        Key *kd = keys.data();
+        T *vd = values.data();
+        size_t i = n;
+        for (size_t j = unique; j > 0; --j) {
+            while (i > pos[j - 1]) {
+                --i;
+                kd[i + j] = std::move(kd[i]);
+                vd[i + j] = std::move(vd[i]);
+            }
+            kd[i + j - 1] = std::move(staged_keys.data()[order[j - 1]]);
+            vd[i + j - 1] = std::move(staged_values.data()[order[j - 1]]);
+        }
+        delete[] order;
+    }
+
+    /**
+     * erase the element at pos.
+     * throw invalid_iterator if pos is end() or belongs to another map.
+     */
+    void erase(iterator pos) {
+        if (pos.map_ptr != this || pos.index >= keys.size()) {
+            throw invalid_iterator();
+        }
+        keys.erase(pos.index);
+        values.erase(pos.index);
+    }
+
+    /**
+     * Returns the number of elements with key, which is either 1 or 0.
+     */
+    size_t count(const Key &key) const {
+        return find_index(key) == keys.size() ? 0 : 1;
+    }
+
+    /**
+     * Finds an element with key equivalent to key, or returns end().
+     */
+    iterator find(const Key &key) {
+        return iterator(this, find_index(key));
+    }
+
+    const_iterator find(const Key &key) const {
+        return const_iterator(this, find_index(key));
+    }
+};
+
+}  // namespace sjtu
+
+#endif
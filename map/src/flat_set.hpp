@@ -0,0 +1,229 @@
+/**
+ * implement a container like std::flat_set
+ */
+#ifndef SJTU_FLAT_SET_HPP
+#define SJTU_FLAT_SET_HPP
+
+// only for std::less<T>
+#include <cstddef>
+#include <functional>
+
+#include "exceptions.hpp"
+#include "flat_map.hpp"
+#include "utility.hpp"
+#include "vector.hpp"
+
+namespace sjtu {
+
+/**
+ * a sorted set stored as one sorted sjtu::vector of keys.
+ * see flat_map for the complexity trade-offs.
+ */
+template <class Key, class Compare = std::less<Key> >
+class flat_set {
+   public:
+    typedef Key value_type;
+
+   private:
+    vector<Key> keys;
+
+    size_t find_index(const Key &key) const {
+        size_t n = keys.size();
+        size_t p = flat_detail::lower_bound<Key, Compare>(keys.data(), n, key);
+        if (p < n && !Compare()(key, keys.data()[p])) return p;
+        return n;
+    }
+
+   public:
+    /**
+     * elements of a set are immutable, so iterator and const_iterator are
+     * the same type.
+     */
+    class const_iterator {
+       private:
+        const flat_set *set_ptr;
+        size_t index;
+        friend class flat_set;
+
+       public:
+        const_iterator() : set_ptr(nullptr), index(0) {
+        }
+
+        const_iterator(const flat_set *set_ptr, size_t index)
+            : set_ptr(set_ptr), index(index) {
+        }
+
+        const_iterator operator++(int) {
+            const_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        const_iterator &operator++() {
+            if (set_ptr == nullptr || index >= set_ptr->size()) {
+                throw invalid_iterator();
+            }
+            ++index;
+            return *this;
+        }
+
+        const_iterator operator--(int) {
+            const_iterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        const_iterator &operator--() {
+            if (set_ptr == nullptr || index == 0) {
+                throw invalid_iterator();
+            }
+            --index;
+            return *this;
+        }
+
+        const Key &operator*() const {
+            if (set_ptr == nullptr || index >= set_ptr->size()) {
+                throw invalid_iterator();
+            }
+            return set_ptr->keys.data()[index];
+        }
+
+        const Key *operator->() const {
+            return &**this;
+        }
+
+        bool operator==(const const_iterator &rhs) const {
+            return (index == rhs.index) && (set_ptr == rhs.set_ptr);
+        }
+
+        bool operator!=(const const_iterator &rhs) const {
+            return !(*this == rhs);
+        }
+    };
+    typedef const_iterator iterator;
+
+    flat_set() {
+    }
+
+    flat_set(const flat_set &other) : keys(other.keys) {
+    }
+
+    flat_set &operator=(const flat_set &other) {
+        if (this != &other) {
+            keys = other.keys;
+        }
+        return *this;
+    }
+
+    ~flat_set() {
+    }
+
+    iterator begin() const {
+        return iterator(this, 0);
+    }
+
+    const_iterator cbegin() const {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() const {
+        return iterator(this, keys.size());
+    }
+
+    const_iterator cend() const {
+        return const_iterator(this, keys.size());
+    }
+
+    bool empty() const {
+        return keys.empty();
+    }
+
+    size_t size() const {
+        return keys.size();
+    }
+
+    void clear() {
+        keys.clear();
+    }
+
+    /**
+     * insert a key.
+     * return a pair, the first of the pair is
+     *   the iterator to the new key (or the key that prevented the
+     * insertion), the second one is true if insert successfully, or false.
+     */
+    pair<iterator, bool> insert(const Key &key) {
+        size_t n = keys.size();
+        size_t p = flat_detail::lower_bound<Key, Compare>(keys.data(), n, key);
+        if (p < n && !Compare()(key, keys.data()[p])) {
+            return pair<iterator, bool>(iterator(this, p), false);
+        }
+        keys.insert(p, key);
+        return pair<iterator, bool>(iterator(this, p), true);
+    }
+
+    /**
+     * insert every key of [first, last) that is not present yet.
+     * the batch is sorted once and merged into place; if Compare throws, the
+     * set is left unchanged.
+     */
+    template <class InputIt>
+    void insert(InputIt first, InputIt last) {
+        vector<Key> staged;
+        for (; first != last; ++first) {
+            staged.push_back(*first);
+        }
+        size_t m = staged.size();
+        if (m == 0) return;
+
+        size_t n = keys.size();
+        size_t *order = new size_t[3 * m];
+        size_t *pos = order + 2 * m;
+        size_t unique;
+        try {
+            unique = flat_detail::plan_insert<Key, Compare>(
+                keys.data(), n, staged.data(), m, order, order + m, pos);
+            for (size_t j = 0; j < unique; ++j) {
+                keys.push_back(staged.data()[order[j]]);
+            }
+        } catch (...) {
+            while (keys.size() > n) keys.pop_back();
+            delete[] order;
+            throw;
+        }
+
+        Key *kd = keys.data();
+        size_t i = n;
+        for (size_t j = unique; j > 0; --j) {
+            while (i > pos[j - 1]) {
+                --i;
+                kd[i + j] = std::move(kd[i]);
+            }
+            kd[i + j - 1] = std::move(staged.data()[order[j - 1]]);
+        }
+        delete[] order;
+    }
+
+    /**
+     * erase the key at pos.
+     * throw invalid_iterator if pos is end() or belongs to another set.
+     */
+    void erase(const_iterator pos) {
+        if (pos.set_ptr != this || pos.index >= keys.size()) {
+            throw invalid_iterator();
+        }
+        keys.erase(pos.index);
+    }
+
+    size_t count(const Key &key) const {
+        return find_index(key) == keys.size() ? 0 : 1;
+    }
+
+    const_iterator find(const Key &key) const {
+        return const_iterator(this, find_index(key));
+    }
+};
+
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <string>
+
+#include "priority_queue.hpp"
+
+int live = 0;
+
+// a payload with a destructor, so leaked or double-destroyed nodes show up
+struct Task {
+    int priority;
+    std::string name;
+    Task(int p) : priority(p), name("task-" + std::to_string(p)) {
+        ++live;
+    }
+    Task(const Task &other) : priority(other.priority), name(other.name) {
+        ++live;
+    }
+    ~Task() {
+        --live;
+    }
+};
+
+struct ByPriority {
+    bool operator()(const Task &a, const Task &b) const {
+        return a.priority < b.priority;
+    }
+};
+
+typedef sjtu::priority_queue<Task, ByPriority> queue;
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+bool drains_sorted(queue &q) {
+    int previous = mod;
+    while (!q.empty()) {
+        if (q.top().priority > previous) return false;
+        previous = q.top().priority;
+        q.pop();
+    }
+    return true;
+}
+
+bool test_recycle() {
+    queue q;
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 1000; i++) q.push(Task(Rand()));
+        for (int i = 0; i < 900; i++) q.pop();
+    }
+    return q.size() == 10000 && drains_sorted(q);
+}
+
+bool test_merge_pools() {
+    queue a, b, c;
+    for (int i = 0; i < 5000; i++) a.push(Task(Rand()));
+    for (int i = 0; i < 5000; i++) b.push(Task(Rand()));
+    a.merge(b);
+    for (int i = 0; i < 5000; i++) c.push(Task(Rand()));
+    c.merge(a);
+    // b gave its nodes away and starts over with a pool of its own
+    for (int i = 0; i < 100; i++) b.push(Task(Rand()));
+    for (int i = 0; i < 7000; i++) c.pop();
+    return a.empty() && b.size() == 100 && c.size() == 8000 &&
+           drains_sorted(c) && drains_sorted(b);
+}
+
+bool test_shared_pool() {
+    queue::shared_pool pool;
+    queue *qs[4];
+    for (int i = 0; i < 4; i++) qs[i] = new queue(pool);
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 4; i++) {
+            for (int j = 0; j < 500; j++) qs[i]->push(Task(Rand()));
+        }
+        qs[round % 4]->merge(*qs[(round + 1) % 4]);
+        for (int j = 0; j < 300; j++) qs[(round + 2) % 4]->pop();
+    }
+    queue copy(*qs[0]);
+    size_t total = 0;
+    for (int i = 0; i < 4; i++) total += qs[i]->size();
+    // destroy the queues in a different order than they were made
+    delete qs[2];
+    delete qs[0];
+    bool ok = drains_sorted(*qs[1]) && drains_sorted(copy);
+    delete qs[3];
+    delete qs[1];
+    return ok && total == 4 * 5000 - 10 * 300;
+}
+
+int main() {
+    std::cout << "recycle: " << (test_recycle() ? "passed" : "failed")
+              << std::endl;
+    std::cout << "merge across pools: "
+              << (test_merge_pools() ? "passed" : "failed") << std::endl;
+    std::cout << "shared pool: " << (test_shared_pool() ? "passed" : "failed")
+              << std::endl;
+    std::cout << "live tasks: " << live << std::endl;
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <string>
+
+#include "dary_heap.hpp"
+#include "stable.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+struct Job {
+    int priority;
+    int id;
+};
+
+struct ByPriority {
+    bool operator()(const Job &a, const Job &b) const {
+        return a.priority < b.priority;
+    }
+};
+
+// Random pushes and pops over a few priorities, against a plain array
+// scanned for the highest priority and, among those, the oldest job.
+template <class Engine>
+bool serves_in_arrival_order() {
+    const int N = 1000;
+    static Job jobs[N];
+    int size = 0, next_id = 0;
+    sjtu::priority_queue<Job, ByPriority, sjtu::stable<Engine>> q;
+    for (int step = 0; step < 100000; step++) {
+        if (Rand() % 5 < 3 && size < N) {
+            Job job{Rand() % 4, next_id++};
+            jobs[size++] = job;
+            q.push(job);
+        } else if (size > 0) {
+            int at = 0;
+            for (int i = 1; i < size; i++) {
+                if (jobs[i].priority > jobs[at].priority ||
+                    (jobs[i].priority == jobs[at].priority &&
+                     jobs[i].id < jobs[at].id)) {
+                    at = i;
+                }
+            }
+            if (q.top().id != jobs[at].id) return false;
+            if (q.pop_value().id != jobs[at].id) return false;
+            for (int i = at; i + 1 < size; i++) jobs[i] = jobs[i + 1];
+            size--;
+        }
+        if ((int)q.size() != size) return false;
+    }
+    return true;
+}
+
+// A range build numbers its elements in order; merged queues keep each
+// side's own arrival order.
+template <class Engine>
+bool builds_and_merges_in_order() {
+    typedef sjtu::priority_queue<Job, ByPriority, sjtu::stable<Engine>> queue;
+    static Job jobs[5000];
+    for (int i = 0; i < 5000; i++) jobs[i] = Job{Rand() % 3, i};
+    queue built(jobs, jobs + 5000), other;
+    for (int i = 0; i < 5000; i++) other.emplace(Job{Rand() % 3, 5000 + i});
+    built.merge(other);
+    if (!other.empty() || built.size() != 10000) return false;
+    int last_priority = 3, last_left = -1, last_right = -1;
+    while (!built.empty()) {
+        Job job = built.pop_value();
+        if (job.priority > last_priority) return false;
+        if (job.priority < last_priority) {
+            last_priority = job.priority;
+            last_left = last_right = -1;
+        }
+        int &previous = job.id < 5000 ? last_left : last_right;
+        if (job.id < previous) return false;
+        previous = job.id;
+    }
+    built.assign(jobs, jobs + 5000);
+    for (int i = 0; i < 5000; i++) {
+        if (jobs[i].priority != 2) continue;
+        if (built.top().id != i) return false;
+        built.pop();
+    }
+    return built.empty() || built.top().priority < 2;
+}
+
+int main() {
+    std::cout << (serves_in_arrival_order<sjtu::skew_heap>() &&
+                          serves_in_arrival_order<sjtu::dary_heap<4>>()
+                      ? "ok"
+                      : "mismatch")
+              << std::endl;
+    std::cout << (builds_and_merges_in_order<sjtu::skew_heap>() &&
+                          builds_and_merges_in_order<sjtu::dary_heap<4>>()
+                      ? "ok"
+                      : "mismatch")
+              << std::endl;
+    sjtu::priority_queue<std::string, std::less<std::string>, sjtu::stable<>>
+        words;
+    for (const char *w : {"b", "a", "b", "c", "a"}) words.push(w);
+    while (!words.empty()) std::cout << words.pop_value() << " ";
+    std::cout << std::endl;
+    return 0;
+}
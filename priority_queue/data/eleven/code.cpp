@@ -0,0 +1,124 @@
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "dary_heap.hpp"
+#include "priority_queue.hpp"
+#include "vector.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+template <class Q>
+std::string state(Q q) {
+    std::string s;
+    while (!q.empty()) {
+        s += std::to_string(q.top()) + " ";
+        q.pop();
+    }
+    return s;
+}
+
+// Every way of building engine Q in bulk must pop in the same order as
+// pushing the elements one by one.
+template <class Q>
+bool builds_like_pushes() {
+    for (int n : {0, 1, 2, 3, 63, 64, 65, 1000, 100000}) {
+        sjtu::vector<int> values;
+        Q pushed;
+        for (int i = 0; i < n; i++) {
+            values.push_back(Rand() % 1000);
+            pushed.push(values[i]);
+        }
+        std::string expected = state(pushed);
+
+        Q from_vector(values);
+        Q from_pointers(values.data(), values.data() + n);
+        if (from_vector.size() != (size_t)n || state(from_vector) != expected ||
+            state(from_pointers) != expected) {
+            return false;
+        }
+
+        // a single-pass input range
+        std::stringstream text;
+        for (int i = 0; i < n; i++) text << values[i] << ' ';
+        Q from_stream{std::istream_iterator<int>(text),
+                      std::istream_iterator<int>()};
+        if (state(from_stream) != expected) return false;
+
+        Q assigned;
+        assigned.push(-1);
+        assigned.assign(values);
+        if (assigned.size() != (size_t)n || state(assigned) != expected) {
+            return false;
+        }
+        assigned.push(-2);
+        assigned.assign(values.begin(), values.end());
+        if (state(assigned) != expected) return false;
+    }
+    return true;
+}
+
+const int TRIGGER_VALUE = 100;
+
+struct FaultyCompare {
+    bool operator()(const int &a, const int &b) const {
+        if (a == TRIGGER_VALUE || b == TRIGGER_VALUE) {
+            throw sjtu::runtime_error();
+        }
+        return a < b;
+    }
+};
+
+// A Compare failure during a bulk build throws runtime_error, and assign
+// leaves the old contents in place.
+template <class Q>
+bool rolls_back() {
+    sjtu::vector<int> values;
+    for (int i = 0; i < 1000; i++) values.push_back(i % 90);
+    values.push_back(TRIGGER_VALUE);
+    for (int i = 0; i < 1000; i++) values.push_back(i % 80);
+
+    bool threw = false;
+    try {
+        Q q(values);
+    } catch (sjtu::runtime_error &) {
+        threw = true;
+    }
+    if (!threw) return false;
+
+    Q q;
+    for (int i = 0; i < 10; i++) q.push(i);
+    std::string before = state(q);
+    threw = false;
+    try {
+        q.assign(values);
+    } catch (sjtu::runtime_error &) {
+        threw = true;
+    }
+    return threw && state(q) == before;
+}
+
+int main() {
+    std::cout << (builds_like_pushes<sjtu::priority_queue<int>>() ? "ok"
+                                                                   : "mismatch")
+              << std::endl;
+    std::cout << (builds_like_pushes<sjtu::priority_queue<
+                          int, std::less<int>, sjtu::dary_heap<4>>>()
+                      ? "ok"
+                      : "mismatch")
+              << std::endl;
+    std::cout << (rolls_back<sjtu::priority_queue<int, FaultyCompare>>()
+                      ? "ok"
+                      : "mismatch")
+              << std::endl;
+    std::cout << (rolls_back<sjtu::priority_queue<int, FaultyCompare,
+                                                  sjtu::dary_heap<4>>>()
+                      ? "ok"
+                      : "mismatch")
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "multi_queue.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// Producers and consumers race; every element must come out exactly once.
+bool delivers_once() {
+    const int P = 8, N = 40000;
+    sjtu::multi_queue<int> q(P);
+    static std::atomic<int> seen[P * N];
+    for (int i = 0; i < P * N; i++) seen[i] = 0;
+    std::atomic<int> popped(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < P; t++) {
+        threads.emplace_back([&q, t] {
+            for (int i = 0; i < N; i++) q.push(t * N + i);
+        });
+        threads.emplace_back([&q, &popped] {
+            int value;
+            while (popped.load() < P * N) {
+                if (q.try_pop(value)) {
+                    seen[value]++;
+                    popped++;
+                }
+            }
+        });
+    }
+    for (std::thread &t : threads) t.join();
+    for (int i = 0; i < P * N; i++) {
+        if (seen[i] != 1) return false;
+    }
+    int value;
+    return q.empty() && !q.try_pop(value);
+}
+
+// With no concurrency the pops should stay close to the true order: the
+// mean rank error is bounded by a small multiple of the shard count.
+bool close_to_order() {
+    const int N = 100000;
+    sjtu::multi_queue<int> q(4, 2);
+    static int order[N];
+    for (int i = 0; i < N; i++) order[i] = i;
+    for (int i = N - 1; i > 0; i--) std::swap(order[i], order[Rand() % (i + 1)]);
+    for (int i = 0; i < N; i++) q.push(order[i]);
+
+    // a Fenwick tree over the values still present
+    static int tree[N + 1];
+    for (int i = 1; i <= N; i++) {
+        tree[i]++;
+        if (i + (i & -i) <= N) tree[i + (i & -i)] += tree[i];
+    }
+    long long total_error = 0;
+    int value;
+    for (int k = 0; k < N; k++) {
+        if (!q.try_pop(value)) return false;
+        // present values greater than the popped one
+        int below = 0;
+        for (int i = value + 1; i > 0; i -= i & -i) below += tree[i];
+        total_error += (N - k) - below;
+        for (int i = value + 1; i <= N; i += i & -i) tree[i]--;
+    }
+    return !q.try_pop(value) &&
+           total_error / N <= 4 * (long long)q.shard_count();
+}
+
+bool armed = false;
+
+struct FaultyCompare {
+    bool operator()(int a, int b) const {
+        if (armed) throw sjtu::runtime_error();
+        return a < b;
+    }
+};
+
+// A throwing Compare surfaces as runtime_error and leaves no shard locked.
+bool releases_on_throw() {
+    sjtu::multi_queue<int, FaultyCompare> q(2, 1);
+    for (int i = 0; i < 100; i++) q.push(i);
+    armed = true;
+    int failures = 0;
+    for (int i = 0; i < 10; i++) {
+        try {
+            q.push(1000);
+        } catch (sjtu::runtime_error &) {
+            failures++;
+        }
+    }
+    armed = false;
+    if (failures != 10 || q.size() != 100) return false;
+    int value, popped = 0;
+    while (q.try_pop(value)) popped++;
+    return popped == 100;
+}
+
+int main() {
+    std::cout << (delivers_once() ? "ok" : "mismatch") << std::endl;
+    std::cout << (close_to_order() ? "ok" : "mismatch") << std::endl;
+    std::cout << (releases_on_throw() ? "ok" : "mismatch") << std::endl;
+    return 0;
+}
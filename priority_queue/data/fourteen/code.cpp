@@ -0,0 +1,176 @@
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "priority_queue.hpp"
+#include "radix_heap.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// Shortest paths with a radix heap against the lazy priority_queue.
+bool dijkstra_agrees() {
+    const int V = 20000, E = 200000;
+    static int head[V], next[E], to[E], weight[E];
+    for (int v = 0; v < V; v++) head[v] = -1;
+    for (int e = 0; e < E; e++) {
+        int from = Rand() % V;
+        to[e] = Rand() % V;
+        weight[e] = Rand() % 1000;
+        next[e] = head[from];
+        head[from] = e;
+    }
+    static unsigned long long expected[V], found[V];
+    const unsigned long long INF = ~0ULL;
+    for (int v = 0; v < V; v++) expected[v] = found[v] = INF;
+
+    typedef std::pair<unsigned long long, int> item;
+    sjtu::priority_queue<item, std::greater<item>> pq;
+    expected[0] = 0;
+    pq.push(item(0, 0));
+    while (!pq.empty()) {
+        item top = pq.top();
+        pq.pop();
+        if (top.first != expected[top.second]) continue;
+        for (int e = head[top.second]; e != -1; e = next[e]) {
+            if (top.first + weight[e] < expected[to[e]]) {
+                expected[to[e]] = top.first + weight[e];
+                pq.push(item(expected[to[e]], to[e]));
+            }
+        }
+    }
+
+    sjtu::radix_heap<unsigned long long, int> q;
+    found[0] = 0;
+    q.push(0, 0);
+    while (!q.empty()) {
+        unsigned long long d = q.top_key();
+        int v = q.pop_value();
+        if (d != found[v]) continue;
+        for (int e = head[v]; e != -1; e = next[e]) {
+            if (d + weight[e] < found[to[e]]) {
+                found[to[e]] = d + weight[e];
+                q.push(found[to[e]], to[e]);
+            }
+        }
+    }
+    for (int v = 0; v < V; v++) {
+        if (expected[v] != found[v]) return false;
+    }
+    return true;
+}
+
+// A monotone workload over key type K: pushes never go below the last key
+// taken, and every pop must return the smallest key present.
+template <class K>
+bool monotone(K (*make)(int)) {
+    sjtu::radix_heap<K, int> q;
+    sjtu::priority_queue<K, std::greater<K>> reference;
+    K floor = make(0);
+    for (int i = 0; i < 100000; i++) {
+        if (Rand() % 3 || q.empty()) {
+            K key = make(Rand());
+            if (key < floor) key = floor;
+            q.push(key, i);
+            reference.push(key);
+        } else {
+            if (q.top_key() != reference.top()) return false;
+            floor = q.top_key();
+            q.pop();
+            reference.pop();
+        }
+        if (q.size() != reference.size()) return false;
+    }
+    while (!q.empty()) {
+        if (q.top_key() != reference.top()) return false;
+        q.pop();
+        reference.pop();
+    }
+    return reference.empty();
+}
+
+unsigned char small(int r) {
+    return r % 256;
+}
+long long signed_key(int r) {
+    return (long long)(r % 2001 - 1000) * 1000000007LL;
+}
+int narrow(int r) {
+    return r % 2001 - 1000;
+}
+double floating(int r) {
+    return (r % 20001 - 10000) / 7.0;
+}
+float single(int r) {
+    return (r % 2001 - 1000) * 0.125f;
+}
+
+// Keys below the floor are refused without any change; merge, copy and
+// move-only payloads behave.
+bool edges() {
+    sjtu::radix_heap<int, std::string> q;
+    q.push(-5, "a");
+    q.push(3, "b");
+    q.push(-5, "c");
+    if (q.top_key() != -5) return false;
+    q.pop();
+    bool threw = false;
+    try {
+        q.push(-6, "low");
+    } catch (sjtu::runtime_error &) {
+        threw = true;
+    }
+    if (!threw || q.size() != 2 || q.top_key() != -5) return false;
+
+    sjtu::radix_heap<int, std::string> other;
+    other.push(-100, "x");
+    threw = false;
+    try {
+        q.merge(other);
+    } catch (sjtu::runtime_error &) {
+        threw = true;
+    }
+    if (!threw || q.size() != 2 || other.size() != 1) return false;
+    other.pop();
+    for (int i = 0; i < 100; i++) other.push(i, std::to_string(i));
+    q.merge(other);
+    if (q.size() != 102 || !other.empty()) return false;
+
+    sjtu::radix_heap<int, std::string> copy(q), assigned;
+    assigned = copy;
+    std::string s, t;
+    while (!q.empty()) {
+        s += std::to_string(q.top_key()) + " ";
+        q.pop();
+    }
+    while (!assigned.empty()) {
+        t += std::to_string(assigned.top_key()) + " ";
+        assigned.pop();
+    }
+    if (s != t || copy.size() != 102) return false;
+
+    sjtu::radix_heap<unsigned, std::unique_ptr<int>> owners;
+    for (unsigned i = 0; i < 1000; i++) {
+        owners.emplace(1000 - i, new int(1000 - i));
+    }
+    for (unsigned i = 1; i <= 1000; i++) {
+        if (*owners.pop_value() != (int)i) return false;
+    }
+    return true;
+}
+
+int main() {
+    std::cout << (dijkstra_agrees() ? "ok" : "mismatch") << std::endl;
+    std::cout << (monotone<unsigned char>(small) ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (monotone<int>(narrow) ? "ok" : "mismatch") << std::endl;
+    std::cout << (monotone<long long>(signed_key) ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (monotone<double>(floating) ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (monotone<float>(single) ? "ok" : "mismatch") << std::endl;
+    std::cout << (edges() ? "ok" : "mismatch") << std::endl;
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <string>
+
+#include "dary_heap.hpp"
+#include "priority_queue.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// Replays one random workload on the skew heap and on engine Q and checks
+// that every top() agrees.
+template <class Q>
+bool same_as_skew_heap() {
+    sjtu::priority_queue<int> reference, other_reference;
+    Q q, other;
+    for (int i = 0; i < 200000; i++) {
+        int op = Rand() % 8, value = Rand();
+        if (op < 4) {
+            reference.push(value);
+            q.push(value);
+        } else if (op < 7) {
+            if (reference.empty() != q.empty()) return false;
+            if (!q.empty()) {
+                if (reference.top() != q.top()) return false;
+                reference.pop();
+                q.pop();
+            }
+        } else {
+            other_reference.push(value);
+            other.push(value);
+            if (i % 1000 == 0) {
+                reference.merge(other_reference);
+                q.merge(other);
+                if (!other.empty() || q.size() != reference.size()) {
+                    return false;
+                }
+            }
+        }
+    }
+    Q copy(q);
+    Q assigned;
+    assigned.push(1);
+    assigned = copy;
+    while (!reference.empty()) {
+        if (assigned.empty() || reference.top() != assigned.top()) {
+            return false;
+        }
+        reference.pop();
+        assigned.pop();
+    }
+    return assigned.empty() && copy.size() == q.size();
+}
+
+const int TRIGGER_VALUE = 100;
+bool force_exception = false;
+
+struct FaultyCompare {
+    bool operator()(const int &a, const int &b) const {
+        if (force_exception || a == TRIGGER_VALUE || b == TRIGGER_VALUE) {
+            throw sjtu::runtime_error();
+        }
+        return a < b;
+    }
+};
+
+template <class Q>
+std::string state(Q q) {
+    std::string s;
+    while (!q.empty()) {
+        s += std::to_string(q.top()) + " ";
+        q.pop();
+    }
+    return s;
+}
+
+// The FaultyCompare scenarios of data/six, against engine Q.
+template <class Q>
+bool rolls_back() {
+    Q a, b;
+    for (int i = 0; i < 100; i++) a.push(Rand() % 90 + 1);
+    for (int i = 0; i < 100; i++) b.push(Rand() % 90 + 1);
+    std::string before_a = state(a), before_b = state(b);
+
+    int thrown = 0;
+    try {
+        a.push(TRIGGER_VALUE);
+    } catch (sjtu::runtime_error &) {
+        thrown++;
+    }
+    force_exception = true;
+    try {
+        a.pop();
+    } catch (sjtu::runtime_error &) {
+        thrown++;
+    }
+    try {
+        a.merge(b);
+    } catch (sjtu::runtime_error &) {
+        thrown++;
+    }
+    force_exception = false;
+    if (thrown != 3 || state(a) != before_a || state(b) != before_b) {
+        return false;
+    }
+    a.merge(b);
+    return b.empty() && a.size() == 200;
+}
+
+template <class Q>
+void run(const char *name) {
+    bool ok = same_as_skew_heap<Q>();
+    std::cout << name << ": " << (ok ? "passed" : "failed") << ", rollback "
+              << (rolls_back<sjtu::priority_queue<int, FaultyCompare,
+                                                  typename Q::engine_tag>>()
+                      ? "passed"
+                      : "failed")
+              << std::endl;
+}
+
+template <size_t D>
+struct tagged : sjtu::priority_queue<int, std::less<int>, sjtu::dary_heap<D>> {
+    typedef sjtu::dary_heap<D> engine_tag;
+};
+
+int main() {
+    run<tagged<2>>("binary heap");
+    run<tagged<4>>("4-ary heap");
+    run<tagged<8>>("8-ary heap");
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "dary_heap.hpp"
+#include "stable.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// Batches of 1 to 1024 pulled between bursts of pushes, against popping
+// a plain queue one element at a time.
+template <class Engine>
+bool batches_match_pops() {
+    sjtu::priority_queue<int, std::less<int>, Engine> q;
+    sjtu::priority_queue<int> reference;
+    static int batch[1024];
+    for (int round = 0; round < 300; round++) {
+        int pushes = Rand() % 2000;
+        for (int i = 0; i < pushes; i++) {
+            int value = Rand() % 10000;
+            q.push(value);
+            reference.push(value);
+        }
+        size_t k = Rand() % 1024 + 1;
+        int *end = q.pop_k(k, batch);
+        size_t expected = k < reference.size() ? k : reference.size();
+        if ((size_t)(end - batch) != expected) return false;
+        for (int *p = batch; p != end; ++p) {
+            if (*p != reference.top()) return false;
+            reference.pop();
+        }
+        if (q.size() != reference.size()) return false;
+    }
+    static int all[700000];
+    int *end = q.drain_sorted(all);
+    if (!q.empty() || (size_t)(end - all) != reference.size()) return false;
+    for (int *p = all; p != end; ++p) {
+        if (*p != reference.top()) return false;
+        reference.pop();
+    }
+    return true;
+}
+
+struct ByPointee {
+    bool operator()(const std::unique_ptr<int> &a,
+                    const std::unique_ptr<int> &b) const {
+        return *a < *b;
+    }
+};
+
+// Elements are moved out, so move-only ones work.
+template <class Engine>
+bool moves_elements() {
+    sjtu::priority_queue<std::unique_ptr<int>, ByPointee, Engine> q;
+    for (int i = 0; i < 100; i++) q.push(std::make_unique<int>(i * 37 % 100));
+    std::unique_ptr<int> out[100];
+    std::unique_ptr<int> *end = q.pop_k(10, out);
+    end = q.drain_sorted(end);
+    if (end != out + 100 || !q.empty()) return false;
+    for (int i = 0; i < 100; i++) {
+        if (!out[i] || *out[i] != 99 - i) return false;
+    }
+    return true;
+}
+
+int countdown = -1;
+
+struct FaultyCompare {
+    bool operator()(const std::string &a, const std::string &b) const {
+        if (countdown >= 0 && countdown-- == 0) throw sjtu::runtime_error();
+        return a < b;
+    }
+};
+
+template <class Queue>
+std::string state(Queue q) {
+    std::string s;
+    while (!q.empty()) {
+        s += q.top() + " ";
+        q.pop();
+    }
+    return s;
+}
+
+// A comparison failing anywhere in pop_k or drain_sorted leaves every
+// element in the queue.
+template <class Engine>
+bool rolls_back() {
+    typedef sjtu::priority_queue<std::string, FaultyCompare, Engine> faulty;
+    for (int op = 0; op < 2; op++) {
+        for (int fail_at = 0; fail_at < 400; fail_at++) {
+            faulty q;
+            for (int i = 0; i < 100; i++) {
+                q.push(std::to_string(Rand() % 1000));
+            }
+            std::string before = state(q);
+            std::string out[100];
+            countdown = fail_at;
+            bool threw = false;
+            try {
+                if (op == 0) q.pop_k(30, out);
+                if (op == 1) q.drain_sorted(out);
+            } catch (sjtu::runtime_error &) {
+                threw = true;
+            }
+            countdown = -1;
+            if (threw && (q.size() != 100 || state(q) != before)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// An output that fails part way: what was not written stays queued.
+struct Full {};
+
+struct LimitedOutput {
+    int *at;
+    int room;
+    LimitedOutput &operator*() {
+        return *this;
+    }
+    LimitedOutput &operator++() {
+        ++at;
+        return *this;
+    }
+    LimitedOutput &operator=(int value) {
+        if (room-- == 0) throw Full();
+        *at = value;
+        return *this;
+    }
+};
+
+template <class Engine>
+bool keeps_unwritten() {
+    sjtu::priority_queue<int, std::less<int>, Engine> q;
+    for (int i = 0; i < 200; i++) q.push(i);
+    int out[200];
+    try {
+        q.pop_k(50, LimitedOutput{out, 20});
+        return false;
+    } catch (Full &) {
+    }
+    if (q.size() != 180) return false;
+    for (int i = 0; i < 20; i++) {
+        if (out[i] != 199 - i) return false;
+    }
+    for (int i = 179; i >= 0; i--) {
+        if (q.top() != i) return false;
+        q.pop();
+    }
+    return true;
+}
+
+template <class Engine>
+bool engine_ok() {
+    return batches_match_pops<Engine>() && moves_elements<Engine>() &&
+           rolls_back<Engine>() && keeps_unwritten<Engine>();
+}
+
+int main() {
+    std::cout << (engine_ok<sjtu::skew_heap>() ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (engine_ok<sjtu::dary_heap<4>>() ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (engine_ok<sjtu::stable<>>() ? "ok" : "mismatch")
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <iostream>
+
+#include "priority_queue.hpp"
+
+// Pushing increasing keys into a skew heap builds one long chain; pushing a
+// small key afterwards swings that chain onto the right spine, so the next
+// merge walks all of it. A recursive merge, copy or clear overflows the stack
+// on heaps this deep.
+const int N = 1000000;
+
+bool test_deep_merge() {
+    sjtu::priority_queue<int> pq;
+    for (int i = 1; i <= N; i++) pq.push(i);
+    pq.push(0);
+    pq.push(-1);
+    pq.push(-2);
+    if (pq.size() != (size_t)N + 3 || pq.top() != N) return false;
+    for (int i = N; i >= N - 9; i--) {
+        if (pq.top() != i) return false;
+        pq.pop();
+    }
+    return true;
+}
+
+bool test_deep_copy() {
+    sjtu::priority_queue<int> pq;
+    for (int i = 1; i <= N; i++) pq.push(i);
+    sjtu::priority_queue<int> copy(pq);
+    pq.push(N + 1);
+    sjtu::priority_queue<int> assigned;
+    assigned.push(42);
+    assigned = pq;
+    if (copy.size() != (size_t)N || copy.top() != N) return false;
+    if (assigned.size() != (size_t)N + 1 || assigned.top() != N + 1) {
+        return false;
+    }
+    for (int i = N; i >= N - 9; i--) {
+        if (copy.top() != i) return false;
+        copy.pop();
+    }
+    return true;
+}
+
+bool test_deep_merge_queues() {
+    sjtu::priority_queue<int> a, b;
+    for (int i = 1; i <= N / 2; i++) a.push(2 * i);
+    for (int i = 1; i <= N / 2; i++) b.push(2 * i - 1);
+    a.push(-1);
+    b.push(-1);
+    a.merge(b);
+    if (!b.empty() || a.size() != (size_t)N + 2) return false;
+    for (int i = N; i >= N - 99; i--) {
+        if (a.top() != i) return false;
+        a.pop();
+    }
+    return true;
+}
+
+// An assignment whose element copy fails leaves the target as it was.
+int copies_left = -1;
+
+struct Fragile {
+    int value;
+    Fragile(int value) : value(value) {
+    }
+    Fragile(const Fragile &other) : value(other.value) {
+        if (copies_left >= 0 && copies_left-- == 0) throw 1;
+    }
+    Fragile &operator=(const Fragile &) = default;
+    bool operator<(const Fragile &other) const {
+        return value < other.value;
+    }
+};
+
+bool test_failed_assignment() {
+    sjtu::priority_queue<Fragile> a, b;
+    for (int i = 0; i < 5; i++) a.push(Fragile(100 + i));
+    for (int i = 0; i < 10; i++) b.push(Fragile(i));
+    copies_left = 3;
+    try {
+        a = b;
+        return false;
+    } catch (int) {
+    }
+    copies_left = -1;
+    if (a.size() != 5 || b.size() != 10) return false;
+    for (int i = 104; i >= 100; i--) {
+        if (a.empty() || a.top().value != i) return false;
+        a.pop();
+    }
+    a = b;
+    return a.size() == 10 && a.top().value == 9;
+}
+
+int main() {
+    std::cout << "deep merge: " << (test_deep_merge() ? "passed" : "failed")
+              << std::endl;
+    std::cout << "deep copy: " << (test_deep_copy() ? "passed" : "failed")
+              << std::endl;
+    std::cout << "deep queue merge: "
+              << (test_deep_merge_queues() ? "passed" : "failed") << std::endl;
+    std::cout << "failed assignment: "
+              << (test_failed_assignment() ? "passed" : "failed") << std::endl;
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <string>
+
+#include "min_max_heap.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// Random pushes and pops at both ends, checked against a plain array
+// scanned for its extremes.
+bool matches_brute_force() {
+    const int N = 1000;
+    static int values[N];
+    int size = 0;
+    sjtu::min_max_heap<int> heap;
+    for (int step = 0; step < 100000; step++) {
+        int op = Rand() % 5;
+        if (op < 3 && size < N) {
+            int value = Rand() % 5000;
+            values[size++] = value;
+            heap.push(value);
+        } else if (size > 0) {
+            int at = 0;
+            for (int i = 1; i < size; i++) {
+                if (op % 2 ? values[i] < values[at] : values[i] > values[at]) {
+                    at = i;
+                }
+            }
+            if (op % 2) {
+                heap.pop_min();
+            } else {
+                heap.pop_max();
+            }
+            values[at] = values[--size];
+        }
+        if ((int)heap.size() != size) return false;
+        if (size == 0) continue;
+        int least = values[0], greatest = values[0];
+        for (int i = 1; i < size; i++) {
+            if (values[i] < least) least = values[i];
+            if (values[i] > greatest) greatest = values[i];
+        }
+        if (heap.min() != least || heap.max() != greatest) return false;
+    }
+    sjtu::min_max_heap<int> copy(heap), assigned;
+    assigned.push(1);
+    assigned = copy;
+    while (!heap.empty()) {
+        if (assigned.max() != heap.max()) return false;
+        heap.pop_max();
+        assigned.pop_max();
+    }
+    return assigned.empty() && copy.size() == (size_t)size;
+}
+
+long long countdown = -1;
+
+struct FaultyCompare {
+    bool operator()(const std::string &a, const std::string &b) const {
+        if (countdown >= 0 && countdown-- == 0) throw sjtu::runtime_error();
+        return a < b;
+    }
+};
+
+typedef sjtu::min_max_heap<std::string, FaultyCompare> faulty;
+
+std::string state(faulty heap) {
+    std::string s;
+    while (!heap.empty()) {
+        s += heap.min() + " ";
+        heap.pop_min();
+    }
+    return s;
+}
+
+// Interrupt push, pop_min and pop_max at every comparison they make.
+bool rolls_back() {
+    for (int op = 0; op < 3; op++) {
+        for (int fail_at = 0; fail_at < 30; fail_at++) {
+            faulty heap;
+            for (int i = 0; i < 200; i++) {
+                heap.push(std::to_string(Rand() % 1000));
+            }
+            std::string before = state(heap);
+            countdown = fail_at;
+            bool threw = false;
+            try {
+                if (op == 0) heap.push(std::to_string(Rand() % 1000));
+                if (op == 1) heap.pop_min();
+                if (op == 2) heap.pop_max();
+            } catch (sjtu::runtime_error &) {
+                threw = true;
+            }
+            countdown = -1;
+            if (threw && (heap.size() != 200 || state(heap) != before)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main() {
+    std::cout << (matches_brute_force() ? "ok" : "mismatch") << std::endl;
+    std::cout << (rolls_back() ? "ok" : "mismatch") << std::endl;
+    sjtu::min_max_heap<int, std::greater<int>> reversed;
+    for (int i = 0; i < 10; i++) reversed.push(i);
+    std::cout << reversed.min() << " " << reversed.max() << std::endl;
+    return 0;
+}
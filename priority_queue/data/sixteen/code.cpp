@@ -0,0 +1,122 @@
+#include <iostream>
+#include <string>
+
+#include "priority_queue.hpp"
+#include "top_k.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// The best k of a long stream, against popping a full priority_queue.
+bool keeps_best(size_t k) {
+    const int N = 300000;
+    sjtu::top_k<int> best(k);
+    sjtu::priority_queue<int> all;
+    int start = last, kept = 0;
+    for (int i = 0; i < N; i++) {
+        int value = Rand();
+        if (best.push(value)) kept++;
+    }
+    last = start;
+    for (int i = 0; i < N; i++) all.push(Rand());
+
+    static int out[1000];
+    int *end = best.drain(out);
+    if ((size_t)(end - out) != (k < (size_t)N ? k : N) || !best.empty()) {
+        return false;
+    }
+    for (int *p = out; p != end; ++p) {
+        if (*p != all.top()) return false;
+        all.pop();
+    }
+    // a random stream enters O(k log(N / k)) times
+    return kept < (int)(k * 20 + 100);
+}
+
+bool armed = false;
+int countdown = 0;
+
+struct FaultyCompare {
+    bool operator()(const std::string &a, const std::string &b) const {
+        if (armed && countdown-- == 0) throw sjtu::runtime_error();
+        return a < b;
+    }
+};
+
+typedef sjtu::top_k<std::string, FaultyCompare> faulty;
+
+std::string contents(faulty q) {
+    std::string out[64], s;
+    std::string *end = q.drain(out);
+    for (std::string *p = out; p != end; ++p) s += *p + " ";
+    return s;
+}
+
+// Comparisons failing anywhere in push or drain leave the kept elements
+// as they were.
+bool rolls_back() {
+    for (int op = 0; op < 2; op++) {
+        for (int fail_at = 0; fail_at < 200; fail_at++) {
+            faulty q(40);
+            for (int i = 0; i < 60; i++) {
+                q.push(std::to_string(Rand() % 1000));
+            }
+            std::string before = contents(q);
+            std::string candidate = "999";
+            armed = true;
+            countdown = fail_at;
+            bool threw = false;
+            std::string out[64];
+            try {
+                if (op == 0) {
+                    q.push(candidate);
+                } else {
+                    q.drain(out);
+                }
+            } catch (sjtu::runtime_error &) {
+                threw = true;
+            }
+            armed = false;
+            if (threw && (q.size() != 40 || contents(q) != before)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Copies of a partly filled container fill up on their own, to the same
+// capacity; an assigned one takes the capacity it is given.
+bool copies() {
+    sjtu::top_k<int> a(8);
+    for (int i = 0; i < 5; i++) a.push(i);
+    sjtu::top_k<int> b(a);
+    for (int i = 10; i < 20; i++) b.push(i);
+    sjtu::top_k<int> c(3);
+    c.push(100);
+    c = b;
+    c.push(30);
+    int out[8];
+    int *end = a.drain(out);
+    if (end - out != 5 || out[0] != 4 || out[4] != 0) return false;
+    end = b.drain(out);
+    if (end - out != 8 || out[0] != 19 || out[7] != 12) return false;
+    end = c.drain(out);
+    return c.capacity() == 8 && end - out == 8 && out[0] == 30 &&
+           out[7] == 13;
+}
+
+int main() {
+    std::cout << (keeps_best(1) && keeps_best(10) && keeps_best(1000)
+                      ? "ok"
+                      : "mismatch")
+              << std::endl;
+    sjtu::top_k<int> none(0);
+    std::cout << (!none.push(1) && none.empty() ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (rolls_back() ? "ok" : "mismatch") << std::endl;
+    std::cout << (copies() ? "ok" : "mismatch") << std::endl;
+    return 0;
+}
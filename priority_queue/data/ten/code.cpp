@@ -0,0 +1,211 @@
+#include <iostream>
+#include <string>
+
+#include "addressable_priority_queue.hpp"
+#include "priority_queue.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+typedef sjtu::addressable_priority_queue<int> queue;
+
+// Random pushes, pops, key changes and erasures, checked against a plain
+// array scanned for its maximum.
+bool matches_brute_force() {
+    const int N = 2000;
+    queue q, other;
+    queue::handle handle[N];
+    int key[N];
+    bool alive[N] = {};
+    bool in_other[N] = {};
+    for (int step = 0; step < 200000; step++) {
+        int op = Rand() % 10, id = Rand() % N, value = Rand();
+        if (op < 3) {
+            if (alive[id]) continue;
+            alive[id] = true;
+            key[id] = value;
+            in_other[id] = op == 2;
+            handle[id] = (op == 2 ? other : q).push(value);
+        } else if (op == 3) {
+            if (q.empty()) continue;
+            queue::handle h = q.top_handle();
+            for (id = 0; handle[id] != h || !alive[id] || in_other[id]; id++) {
+            }
+            alive[id] = false;
+            q.pop();
+        } else if (op < 8) {
+            if (!alive[id]) continue;
+            queue& owner = in_other[id] ? other : q;
+            if (op == 4) {
+                if (value < key[id]) value = key[id] + value % 1000;
+                owner.increase_key(handle[id], value);
+            } else if (op == 5) {
+                if (value > key[id]) value = key[id] - value % 1000;
+                owner.decrease_key(handle[id], value);
+            } else {
+                owner.update(handle[id], value);
+            }
+            key[id] = value;
+            if (owner.get(handle[id]) != value) return false;
+        } else if (op == 8) {
+            if (!alive[id]) continue;
+            (in_other[id] ? other : q).erase(handle[id]);
+            alive[id] = false;
+        } else if (step % 50 == 0) {
+            q.merge(other);
+            for (int i = 0; i < N; i++) in_other[i] = false;
+            if (!other.empty()) return false;
+        }
+        int best = -1, count = 0;
+        for (int i = 0; i < N; i++) {
+            if (alive[i] && !in_other[i]) {
+                count++;
+                if (best < 0 || key[i] > best) best = key[i];
+            }
+        }
+        if ((int)q.size() != count) return false;
+        if (count && q.top() != best) return false;
+    }
+    queue copy(q);
+    queue assigned;
+    assigned.push(7);
+    assigned = copy;
+    while (!q.empty()) {
+        if (assigned.top() != q.top()) return false;
+        q.pop();
+        assigned.pop();
+    }
+    return assigned.empty() && copy.size() != 0;
+}
+
+// Shortest paths on a random graph: decrease-key on a min-queue against the
+// lazy duplicate-skipping priority_queue.
+bool dijkstra_agrees() {
+    const int V = 5000, E = 40000;
+    static int head[V], next[E], to[E], weight[E];
+    for (int v = 0; v < V; v++) head[v] = -1;
+    for (int e = 0; e < E; e++) {
+        int from = Rand() % V;
+        to[e] = Rand() % V;
+        weight[e] = Rand() % 1000 + 1;
+        next[e] = head[from];
+        head[from] = e;
+    }
+    const long long INF = 1LL << 60;
+    static long long lazy[V], addressed[V];
+    for (int v = 0; v < V; v++) lazy[v] = addressed[v] = INF;
+
+    typedef std::pair<long long, int> item;
+    sjtu::priority_queue<item, std::greater<item>> pq;
+    lazy[0] = 0;
+    pq.push(item(0, 0));
+    while (!pq.empty()) {
+        item top = pq.top();
+        pq.pop();
+        if (top.first != lazy[top.second]) continue;
+        for (int e = head[top.second]; e != -1; e = next[e]) {
+            if (top.first + weight[e] < lazy[to[e]]) {
+                lazy[to[e]] = top.first + weight[e];
+                pq.push(item(lazy[to[e]], to[e]));
+            }
+        }
+    }
+
+    sjtu::addressable_priority_queue<item, std::greater<item>> q;
+    static sjtu::addressable_priority_queue<item,
+                                            std::greater<item>>::handle h[V];
+    static bool queued[V];
+    addressed[0] = 0;
+    h[0] = q.push(item(0, 0));
+    queued[0] = true;
+    while (!q.empty()) {
+        item top = q.top();
+        q.pop();
+        queued[top.second] = false;
+        for (int e = head[top.second]; e != -1; e = next[e]) {
+            long long d = top.first + weight[e];
+            if (d >= addressed[to[e]]) continue;
+            addressed[to[e]] = d;
+            if (queued[to[e]]) {
+                // a shorter distance ranks higher under std::greater
+                q.increase_key(h[to[e]], item(d, to[e]));
+            } else {
+                h[to[e]] = q.push(item(d, to[e]));
+                queued[to[e]] = true;
+            }
+        }
+    }
+    for (int v = 0; v < V; v++) {
+        if (lazy[v] != addressed[v]) return false;
+    }
+    return true;
+}
+
+// Throws on the n-th comparison from now, if armed.
+long long countdown = -1;
+
+struct FaultyCompare {
+    bool operator()(const int& a, const int& b) const {
+        if (countdown >= 0 && countdown-- == 0) throw sjtu::runtime_error();
+        return a < b;
+    }
+};
+
+typedef sjtu::addressable_priority_queue<int, FaultyCompare> faulty_queue;
+
+std::string state(faulty_queue q) {
+    std::string s;
+    while (!q.empty()) {
+        s += std::to_string(q.top()) + " ";
+        q.pop();
+    }
+    return s;
+}
+
+// Interrupts every kind of operation at every comparison it makes and
+// checks that the queue and its handles come through unchanged.
+bool rolls_back() {
+    for (int op = 0; op < 5; op++) {
+        for (int fail_at = 0; fail_at < 40; fail_at++) {
+            faulty_queue q;
+            faulty_queue::handle h[64];
+            for (int i = 0; i < 64; i++) h[i] = q.push(Rand() % 500);
+            // shape the heap a bit so pops have children to pair
+            q.pop();
+            h[0] = q.push(Rand() % 500);
+            int target = Rand() % 64;
+            if (q.top_handle() == h[target]) target = (target + 1) % 64;
+            std::string before = state(q);
+            int key = q.get(h[target]);
+            countdown = fail_at;
+            bool threw = false;
+            try {
+                if (op == 0) q.pop();
+                if (op == 1) q.erase(h[target]);
+                if (op == 2) q.increase_key(h[target], key + 1000);
+                if (op == 3) q.decrease_key(h[target], key - 1000);
+                if (op == 4) q.decrease_key(q.top_handle(), -1);
+            } catch (sjtu::runtime_error&) {
+                threw = true;
+            }
+            countdown = -1;
+            if (!threw) continue;
+            if (state(q) != before || q.get(h[target]) != key) return false;
+            // the handles still work after the rollback
+            q.increase_key(h[target], 100000);
+            if (q.top() != 100000) return false;
+            q.erase(h[target]);
+            if (q.size() != 63) return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    std::cout << (matches_brute_force() ? "ok" : "mismatch") << std::endl;
+    std::cout << (dijkstra_agrees() ? "ok" : "mismatch") << std::endl;
+    std::cout << (rolls_back() ? "ok" : "mismatch") << std::endl;
+    return 0;
+}
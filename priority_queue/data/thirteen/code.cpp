@@ -0,0 +1,132 @@
+#include <iostream>
+#include <string>
+
+#include "addressable_priority_queue.hpp"
+#include "dary_heap.hpp"
+#include "priority_queue.hpp"
+#include "vector.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// Orders ids by a table it points to; the direction is chosen at run time.
+struct ByKey {
+    const int *key;
+    bool descending;
+
+    bool operator()(int a, int b) const {
+        return descending ? key[a] > key[b] : key[a] < key[b];
+    }
+};
+
+int key[1000];
+
+// The keys of the ids in pop order; ids with equal keys may come out in
+// either order.
+template <class Q>
+std::string state(Q q) {
+    std::string s;
+    while (!q.empty()) {
+        s += std::to_string(key[q.top()]) + " ";
+        q.pop();
+    }
+    return s;
+}
+
+// Two queues of one type, ordered differently by their comparators' state,
+// built each way the queue can be built.
+template <class Q>
+bool orders_by_state() {
+    for (int i = 0; i < 1000; i++) key[i] = Rand() % 100000;
+    sjtu::vector<int> ids;
+    for (int i = 0; i < 1000; i++) ids.push_back(i);
+
+    Q up(ByKey{key, false}), down(ByKey{key, true});
+    for (int i = 0; i < 1000; i++) {
+        up.push(i);
+        down.push(i);
+    }
+    Q built_up(ids, ByKey{key, false});
+    Q built_down(ids.begin(), ids.end(), ByKey{key, true});
+    Q copied(down);
+    if (down.value_comp().descending != true) return false;
+    if (state(built_up) != state(up) || state(built_down) != state(down) ||
+        state(copied) != state(down)) {
+        return false;
+    }
+
+    int previous = 1 << 30;
+    while (!up.empty()) {
+        if (key[up.top()] > previous) return false;
+        previous = key[up.top()];
+        up.pop();
+    }
+    previous = -1;
+    while (!down.empty()) {
+        if (key[down.top()] < previous) return false;
+        previous = key[down.top()];
+        down.pop();
+    }
+    return true;
+}
+
+// A capturing lambda cannot be default-constructed and must be stored.
+template <template <class, class> class Q>
+bool takes_lambda() {
+    int offset = 500;
+    auto closer = [&offset](int a, int b) {
+        int da = a > offset ? a - offset : offset - a;
+        int db = b > offset ? b - offset : offset - b;
+        return da > db;
+    };
+    Q<int, decltype(closer)> q(closer);
+    for (int i = 0; i < 1000; i++) q.push(Rand() % 1000);
+    int previous = -1;
+    while (!q.empty()) {
+        int distance = q.top() > offset ? q.top() - offset : offset - q.top();
+        if (distance < previous) return false;
+        previous = distance;
+        q.pop();
+    }
+    return true;
+}
+
+template <class T, class C>
+using skew = sjtu::priority_queue<T, C>;
+template <class T, class C>
+using dary = sjtu::priority_queue<T, C, sjtu::dary_heap<4>>;
+template <class T, class C>
+using addressable = sjtu::addressable_priority_queue<T, C>;
+
+int main() {
+    // a stateless comparator costs nothing
+    std::cout << (sizeof(sjtu::priority_queue<int>) == 3 * sizeof(void *) &&
+                          sizeof(dary<int, std::less<int>>) ==
+                              3 * sizeof(void *) &&
+                          sizeof(addressable<int, std::less<int>>) ==
+                              3 * sizeof(void *)
+                      ? "ok"
+                      : "grown")
+              << std::endl;
+    std::cout << (orders_by_state<skew<int, ByKey>>() ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (orders_by_state<dary<int, ByKey>>() ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (takes_lambda<skew>() && takes_lambda<dary>() &&
+                          takes_lambda<addressable>()
+                      ? "ok"
+                      : "mismatch")
+              << std::endl;
+
+    // the addressable queue keeps its handles under a stateful order
+    sjtu::addressable_priority_queue<int, ByKey> q(ByKey{key, true});
+    sjtu::addressable_priority_queue<int, ByKey>::handle h[1000];
+    for (int i = 0; i < 1000; i++) h[i] = q.push(i);
+    q.erase(h[q.top()]);
+    std::cout << (q.size() == 999 && q.value_comp().key == key ? "ok"
+                                                               : "mismatch")
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "addressable_priority_queue.hpp"
+#include "dary_heap.hpp"
+#include "priority_queue.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+int copies = 0;
+
+// A payload that counts how often it is deep-copied.
+struct Task {
+    int priority;
+    std::string payload;
+
+    Task(int priority, const std::string &payload)
+        : priority(priority), payload(payload) {
+    }
+    Task(const Task &other)
+        : priority(other.priority), payload(other.payload) {
+        copies++;
+    }
+    Task(Task &&other) noexcept
+        : priority(other.priority), payload(std::move(other.payload)) {
+    }
+    Task &operator=(const Task &other) {
+        priority = other.priority;
+        payload = other.payload;
+        copies++;
+        return *this;
+    }
+    Task &operator=(Task &&other) noexcept {
+        priority = other.priority;
+        payload = std::move(other.payload);
+        return *this;
+    }
+    bool operator<(const Task &rhs) const {
+        return priority < rhs.priority;
+    }
+};
+
+// Tasks go in by move and emplace and come out by pop_value: no copies,
+// and they still come out in order.
+template <class Q>
+bool never_copies() {
+    copies = 0;
+    Q q;
+    for (int i = 0; i < 20000; i++) {
+        int priority = Rand() % 1000;
+        std::string payload(100, 'a' + priority % 26);
+        if (i % 2) {
+            q.push(Task(priority, payload));
+        } else {
+            q.emplace(priority, payload);
+        }
+    }
+    int previous = 1000;
+    while (!q.empty()) {
+        Task task = q.pop_value();
+        if (task.priority > previous) return false;
+        if (task.payload != std::string(100, 'a' + task.priority % 26)) {
+            return false;
+        }
+        previous = task.priority;
+    }
+    return copies == 0;
+}
+
+struct PointeeLess {
+    bool operator()(const std::unique_ptr<int> &a,
+                    const std::unique_ptr<int> &b) const {
+        return *a < *b;
+    }
+};
+
+// Move-only elements work too.
+template <class Q>
+bool holds_move_only() {
+    Q q;
+    for (int i = 0; i < 1000; i++) {
+        if (i % 2) {
+            q.push(std::make_unique<int>(Rand() % 100));
+        } else {
+            q.emplace(new int(Rand() % 100));
+        }
+    }
+    int previous = 100;
+    while (!q.empty()) {
+        std::unique_ptr<int> top = q.pop_value();
+        if (*top > previous) return false;
+        previous = *top;
+    }
+    return true;
+}
+
+// Pushing a copy of the queue's own top, even when the array has to grow.
+bool pushes_own_top() {
+    sjtu::priority_queue<std::string, std::less<std::string>,
+                         sjtu::dary_heap<4>>
+        q;
+    q.push(std::string(50, 'z'));
+    for (int i = 0; i < 1000; i++) q.push(q.top());
+    if (q.size() != 1001) return false;
+    while (!q.empty()) {
+        if (q.pop_value() != std::string(50, 'z')) return false;
+    }
+    return true;
+}
+
+int main() {
+    std::cout << (never_copies<sjtu::priority_queue<Task>>() ? "ok"
+                                                             : "copied")
+              << std::endl;
+    std::cout << (never_copies<sjtu::priority_queue<Task, std::less<Task>,
+                                                    sjtu::dary_heap<4>>>()
+                      ? "ok"
+                      : "copied")
+              << std::endl;
+    std::cout << (never_copies<sjtu::addressable_priority_queue<Task>>()
+                      ? "ok"
+                      : "copied")
+              << std::endl;
+    std::cout << (holds_move_only<sjtu::priority_queue<std::unique_ptr<int>,
+                                                       PointeeLess>>()
+                      ? "ok"
+                      : "mismatch")
+              << std::endl;
+    std::cout << (holds_move_only<sjtu::priority_queue<
+                          std::unique_ptr<int>, PointeeLess,
+                          sjtu::dary_heap<2>>>()
+                      ? "ok"
+                      : "mismatch")
+              << std::endl;
+    std::cout << (pushes_own_top() ? "ok" : "mismatch") << std::endl;
+    return 0;
+}
@@ -0,0 +1,232 @@
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "dary_heap.hpp"
+#include "stable.hpp"
+#include "vector.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// Bursts of every size, into empty and full queues, against pushing the
+// same elements one by one.
+template <class Engine>
+bool bursts_match_pushes() {
+    sjtu::priority_queue<int, std::less<int>, Engine> q;
+    sjtu::priority_queue<int> reference;
+    static int burst[5000];
+    for (int round = 0; round < 200; round++) {
+        int m = Rand() % 5000;
+        for (int i = 0; i < m; i++) {
+            burst[i] = Rand() % 10000;
+            reference.push(burst[i]);
+        }
+        q.push_range(burst, burst + m);
+        int pops = Rand() % 4000;
+        for (int i = 0; i < pops && !q.empty(); i++) {
+            if (q.top() != reference.top()) return false;
+            q.pop();
+            reference.pop();
+        }
+        if (q.size() != reference.size()) return false;
+    }
+    sjtu::vector<int> more;
+    for (int i = 0; i < 1000; i++) {
+        more.push_back(Rand() % 10000);
+        reference.push(more.back());
+    }
+    q.push_range(more);
+    while (!q.empty()) {
+        if (q.top() != reference.top()) return false;
+        q.pop();
+        reference.pop();
+    }
+    return reference.empty();
+}
+
+int countdown = -1;
+
+struct FaultyCompare {
+    bool operator()(const std::string &a, const std::string &b) const {
+        if (countdown >= 0 && countdown-- == 0) throw sjtu::runtime_error();
+        return a < b;
+    }
+};
+
+template <class Queue>
+std::string state(Queue q) {
+    std::string s;
+    while (!q.empty()) {
+        s += q.top() + " ";
+        q.pop();
+    }
+    return s;
+}
+
+// A comparison failing anywhere in a small or a large burst leaves the
+// queue as it was.
+template <class Engine>
+bool rolls_back() {
+    typedef sjtu::priority_queue<std::string, FaultyCompare, Engine> faulty;
+    for (int m : {30, 300}) {
+        for (int fail_at = 0; fail_at < 600; fail_at++) {
+            faulty q;
+            for (int i = 0; i < 100; i++) {
+                q.push(std::to_string(Rand() % 1000));
+            }
+            std::string burst[300];
+            for (int i = 0; i < m; i++) burst[i] = std::to_string(Rand() % 1000);
+            std::string before = state(q);
+            countdown = fail_at;
+            bool threw = false;
+            try {
+                q.push_range(burst, burst + m);
+            } catch (sjtu::runtime_error &) {
+                threw = true;
+            }
+            countdown = -1;
+            if (threw && (q.size() != 100 || state(q) != before)) {
+                return false;
+            }
+            if (!threw && q.size() != 100 + (size_t)m) return false;
+        }
+    }
+    return true;
+}
+
+// So does an element that fails to copy.
+int copies_left = -1;
+
+struct Fragile {
+    int value;
+    Fragile(int value) : value(value) {
+    }
+    Fragile(const Fragile &other) : value(other.value) {
+        if (copies_left >= 0 && copies_left-- == 0) throw 1;
+    }
+    Fragile &operator=(const Fragile &) = default;
+    bool operator<(const Fragile &other) const {
+        return value < other.value;
+    }
+};
+
+template <class Engine>
+bool survives_failed_copy() {
+    sjtu::priority_queue<Fragile, std::less<Fragile>, Engine> q;
+    for (int i = 0; i < 50; i++) q.push(Fragile(i));
+    Fragile burst[20] = {100, 101, 102, 103, 104, 105, 106, 107, 108, 109,
+                         110, 111, 112, 113, 114, 115, 116, 117, 118, 119};
+    copies_left = 10;
+    try {
+        q.push_range(burst, burst + 20);
+        return false;
+    } catch (int) {
+    }
+    copies_left = -1;
+    if (q.size() != 50) return false;
+    for (int i = 49; i >= 0; i--) {
+        if (q.top().value != i) return false;
+        q.pop();
+    }
+    return true;
+}
+
+// Allocations fail once allocations_left reaches 0; push_range takes its
+// scratch array from here.
+int allocations_left = -1;
+
+void *operator new(std::size_t size) {
+    if (allocations_left >= 0 && allocations_left-- == 0) {
+        throw std::bad_alloc();
+    }
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+// kept out of line: inlined next to a call of operator new, the free()
+// inside would look mismatched to the compiler
+[[gnu::noinline]] void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// A small burst into a 4-ary heap whose scratch array cannot be allocated
+// leaves the heap as it was.
+bool survives_failed_allocation() {
+    sjtu::priority_queue<int, std::less<int>, sjtu::dary_heap<4>> q;
+    for (int i = 0; i < 50; i++) q.push(i);
+    int burst[10] = {100, 101, 102, 103, 104, 105, 106, 107, 108, 109};
+    allocations_left = 0;
+    try {
+        q.push_range(burst, burst + 10);
+        allocations_left = -1;
+        return false;
+    } catch (std::bad_alloc &) {
+    }
+    allocations_left = -1;
+    if (q.size() != 50) return false;
+    q.push_range(burst, burst + 10);
+    for (int i = 109; i >= 100; i--) {
+        if (q.top() != i) return false;
+        q.pop();
+    }
+    for (int i = 49; i >= 0; i--) {
+        if (q.top() != i) return false;
+        q.pop();
+    }
+    return q.empty();
+}
+
+template <class Engine>
+bool engine_ok() {
+    return bursts_match_pushes<Engine>() && rolls_back<Engine>() &&
+           survives_failed_copy<Engine>();
+}
+
+struct Job {
+    int priority;
+    int id;
+};
+
+struct ByPriority {
+    bool operator()(const Job &a, const Job &b) const {
+        return a.priority < b.priority;
+    }
+};
+
+// A burst into a stable queue takes its arrival order from the range.
+bool stable_bursts_keep_order() {
+    sjtu::priority_queue<Job, ByPriority, sjtu::stable<sjtu::dary_heap<4>>> q;
+    Job jobs[100];
+    int id = 0;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 100; i++) jobs[i] = Job{Rand() % 2, id++};
+        q.push_range(jobs, jobs + 100);
+        q.push(Job{1, id++});
+    }
+    int previous[2] = {-1, -1};
+    while (!q.empty()) {
+        Job job = q.pop_value();
+        if (job.id < previous[job.priority]) return false;
+        previous[job.priority] = job.id;
+    }
+    return true;
+}
+
+int main() {
+    std::cout << (engine_ok<sjtu::skew_heap>() ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (engine_ok<sjtu::dary_heap<4>>() ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (stable_bursts_keep_order() ? "ok" : "mismatch") << std::endl;
+    std::cout << (survives_failed_allocation() ? "ok" : "mismatch")
+              << std::endl;
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <functional>
+#include <iostream>
+
+#include "external_queue.hpp"
+#include "priority_queue.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// Pushes and pops through a budget of 4 KiB, so that runs spill, merge
+// level by level and drain, against a queue held in memory.
+bool matches_in_memory() {
+    sjtu::external_priority_queue<int> q(4096);
+    sjtu::priority_queue<int> reference;
+    size_t most_runs = 0;
+    for (int round = 0; round < 40; round++) {
+        int pushes = Rand() % 20000;
+        for (int i = 0; i < pushes; i++) {
+            int x = Rand();
+            q.push(x);
+            reference.push(x);
+        }
+        if (q.run_count() > most_runs) most_runs = q.run_count();
+        int pops = Rand() % 20000;
+        for (int i = 0; i < pops && !reference.empty(); i++) {
+            if (q.top() != reference.top()) return false;
+            if (i % 2) {
+                q.pop();
+            } else if (q.pop_value() != reference.top()) {
+                return false;
+            }
+            reference.pop();
+        }
+        if (q.size() != reference.size()) return false;
+    }
+    while (!reference.empty()) {
+        if (q.top() != reference.top()) return false;
+        q.pop();
+        reference.pop();
+    }
+    return q.empty() && q.run_count() == 0 && most_runs > 1 &&
+           most_runs < 16;
+}
+
+struct Job {
+    long long deadline;
+    int id;
+};
+
+struct Earliest {
+    bool operator()(const Job &a, const Job &b) const {
+        return a.deadline > b.deadline;
+    }
+};
+
+// A million jobs through 64 KiB come out earliest first; every element is
+// written a few times at most and read back once per write.
+bool orders_structs() {
+    sjtu::external_priority_queue<Job, Earliest> q(65536);
+    const int n = 1000000;
+    for (int i = 0; i < n; i++) {
+        q.emplace(Job{(long long)Rand() * 1000 + i % 1000, i});
+    }
+    long long previous = -1;
+    for (int i = 0; i < n; i++) {
+        Job job = q.pop_value();
+        if (job.deadline < previous) return false;
+        previous = job.deadline;
+    }
+    size_t bytes = n * sizeof(Job);
+    return q.empty() && q.bytes_written() >= bytes &&
+           q.bytes_written() <= 4 * bytes &&
+           q.bytes_read() == q.bytes_written();
+}
+
+// Lets the process open one more file than it has open now.
+void allow_one_more_file(const rlimit &original) {
+    setrlimit(RLIMIT_NOFILE, &original);
+    rlimit limit = original;
+    int next = dup(1);
+    close(next);
+    limit.rlim_cur = next + 1;
+    setrlimit(RLIMIT_NOFILE, &limit);
+}
+
+// With the next file the only one allowed, a spill can write its run but the
+// merge after it cannot open one, over and over: the failures leave no more
+// runs than the queue keeps and lose no element.
+bool survives_failed_merges() {
+    rlimit original;
+    getrlimit(RLIMIT_NOFILE, &original);
+    sjtu::external_priority_queue<int> q(4096);
+    sjtu::priority_queue<int> reference;
+    int failures = 0;
+    for (int round = 0; round < 30; round++) {
+        allow_one_more_file(original);
+        for (int i = 0; i < 100000; i++) {
+            int x = Rand();
+            try {
+                q.push(x);
+            } catch (sjtu::runtime_error &) {
+                failures++;
+                break;
+            }
+            reference.push(x);
+        }
+        if (q.size() != reference.size() || q.run_count() > 15) {
+            setrlimit(RLIMIT_NOFILE, &original);
+            return false;
+        }
+    }
+    setrlimit(RLIMIT_NOFILE, &original);
+    for (int i = 0; i < 5000; i++) {
+        int x = Rand();
+        q.push(x);
+        reference.push(x);
+    }
+    while (!reference.empty()) {
+        if (q.top() != reference.top()) return false;
+        q.pop();
+        reference.pop();
+    }
+    return q.empty() && failures > 20;
+}
+
+// With files capped at 8 KiB, spills fit but merges fail partway, after
+// reading into their sources; those are read again from where they were.
+bool survives_failed_writes() {
+    std::signal(SIGXFSZ, SIG_IGN);
+    rlimit original;
+    getrlimit(RLIMIT_FSIZE, &original);
+    rlimit limit = original;
+    limit.rlim_cur = 8192;
+    setrlimit(RLIMIT_FSIZE, &limit);
+    sjtu::external_priority_queue<int> q(4096);
+    sjtu::priority_queue<int> reference;
+    int failures = 0;
+    bool same = true;
+    for (int i = 0; i < 20000 && same; i++) {
+        int x = Rand();
+        try {
+            q.push(x);
+            reference.push(x);
+        } catch (sjtu::runtime_error &) {
+            failures++;
+        }
+        if (i % 7 == 0) {
+            same = q.top() == reference.top();
+            q.pop();
+            reference.pop();
+        }
+    }
+    setrlimit(RLIMIT_FSIZE, &original);
+    while (same && !reference.empty()) {
+        same = q.top() == reference.top();
+        q.pop();
+        reference.pop();
+    }
+    return same && q.empty() && failures > 0;
+}
+
+int main() {
+    std::cout << (matches_in_memory() ? "ok" : "mismatch") << std::endl;
+    std::cout << (orders_structs() ? "ok" : "mismatch") << std::endl;
+    std::cout << (survives_failed_merges() ? "ok" : "mismatch") << std::endl;
+    std::cout << (survives_failed_writes() ? "ok" : "mismatch") << std::endl;
+    sjtu::external_priority_queue<int> q(1 << 20);
+    for (int i = 0; i < 100; i++) q.push(i);
+    std::cout << q.top() << " " << q.size() << " " << q.bytes_written() << " "
+              << q.memory_budget() << std::endl;
+    try {
+        sjtu::external_priority_queue<int>().pop();
+    } catch (sjtu::container_is_empty &) {
+        std::cout << "empty" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "kway_merge.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+struct Item {
+    int key;
+    int run;
+    int index;
+};
+
+long long comparisons = 0;
+
+struct ByKey {
+    bool operator()(const Item &a, const Item &b) const {
+        ++comparisons;
+        return a.key < b.key;
+    }
+};
+
+bool same(const Item &a, const Item &b) {
+    return a.key == b.key && a.run == b.run && a.index == b.index;
+}
+
+size_t ceil_log2(size_t k) {
+    size_t bits = 0;
+    while ((size_t(1) << bits) < k) bits++;
+    return bits;
+}
+
+// Runs of every count and length, with many ties and empty runs, against a
+// stable sort of their concatenation; one comparison per tree level.
+bool matches_stable_sort() {
+    static Item items[100000], expected[100000], merged[100000];
+    for (int round = 0; round < 100; round++) {
+        int k = 1 + Rand() % 300;
+        int n = 0;
+        static int starts[301];
+        for (int r = 0; r < k; r++) {
+            starts[r] = n;
+            int length = Rand() % 4 == 0 ? 0 : Rand() % 300;
+            int key = Rand() % 100;
+            for (int i = 0; i < length; i++) {
+                key += Rand() % 3;
+                items[n++] = Item{key, r, i};
+            }
+        }
+        starts[k] = n;
+        std::copy(items, items + n, expected);
+        std::stable_sort(expected, expected + n, ByKey());
+        sjtu::kway_merge<const Item *, ByKey> m;
+        for (int r = 0; r < k; r++) {
+            m.add(items + starts[r], items + starts[r + 1]);
+        }
+        comparisons = 0;
+        Item *end = m.merge(merged);
+        if (end != merged + n || !m.empty()) return false;
+        if ((size_t)comparisons > (size_t)(k - 1) + n * ceil_log2(k)) {
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            if (!same(merged[i], expected[i])) return false;
+        }
+    }
+    return true;
+}
+
+// Runs of words read once from streams, popped one by one.
+bool merges_input_iterators() {
+    std::istringstream a("apple fig fig pear"), b(""),
+        c("banana cherry fig plum quince");
+    typedef std::istream_iterator<std::string> reader;
+    sjtu::kway_merge<reader> m;
+    m.add(reader(a), reader());
+    m.add(reader(b), reader());
+    m.add(reader(c), reader());
+    std::string out;
+    while (!m.empty()) {
+        out += m.top() + " ";
+        m.pop();
+    }
+    return out == "apple banana cherry fig fig fig pear plum quince ";
+}
+
+struct Sink {
+    int batches = 0;
+    int count = 0;
+    int previous = -1;
+    bool sorted = true;
+    void push_batch(const int *first, const int *last) {
+        batches++;
+        for (; first != last; ++first, ++count) {
+            if (*first < previous) sorted = false;
+            previous = *first;
+        }
+    }
+};
+
+// A sink takes the stream in batches.
+bool feeds_batches() {
+    static int runs[10][1000];
+    sjtu::kway_merge<const int *> m;
+    for (int r = 0; r < 10; r++) {
+        for (int i = 0; i < 1000; i++) runs[r][i] = i * 10 + r;
+        m.add(runs[r], runs[r] + 1000);
+    }
+    Sink sink;
+    m.merge_batched(sink);
+    return sink.sorted && sink.count == 10000 && sink.batches == 40 &&
+           m.empty();
+}
+
+int countdown = -1;
+
+struct FaultyCompare {
+    bool operator()(int a, int b) const {
+        if (countdown >= 0 && countdown-- == 0) throw sjtu::runtime_error();
+        return a < b;
+    }
+};
+
+// records what merge writes, even when it throws
+int written[1000];
+int written_count = 0;
+
+struct Writer {
+    Writer &operator*() {
+        return *this;
+    }
+    Writer &operator++() {
+        return *this;
+    }
+    Writer &operator=(int x) {
+        written[written_count++] = x;
+        return *this;
+    }
+};
+
+// A comparison failing anywhere loses nothing: the merge carries on.
+bool survives_throws() {
+    static int runs[20][50];
+    for (int r = 0; r < 20; r++) {
+        for (int i = 0; i < 50; i++) runs[r][i] = Rand() % 7 + i * 5;
+        std::sort(runs[r], runs[r] + 50);
+    }
+    for (int fail_at = 0; fail_at < 500; fail_at += 7) {
+        sjtu::kway_merge<const int *, FaultyCompare> m;
+        for (int r = 0; r < 20; r++) m.add(runs[r], runs[r] + 50);
+        written_count = 0;
+        countdown = fail_at;
+        bool done = false;
+        while (!done) {
+            try {
+                m.merge(Writer());
+                done = true;
+            } catch (sjtu::runtime_error &) {
+            }
+        }
+        countdown = -1;
+        if (written_count != 1000) return false;
+        if (!std::is_sorted(written, written + 1000)) return false;
+    }
+    return true;
+}
+
+int main() {
+    std::cout << (matches_stable_sort() ? "ok" : "mismatch") << std::endl;
+    std::cout << (merges_input_iterators() ? "ok" : "mismatch") << std::endl;
+    std::cout << (feeds_batches() ? "ok" : "mismatch") << std::endl;
+    std::cout << (survives_throws() ? "ok" : "mismatch") << std::endl;
+    try {
+        sjtu::kway_merge<const int *>().top();
+    } catch (sjtu::container_is_empty &) {
+        std::cout << "empty" << std::endl;
+    }
+    return 0;
+}
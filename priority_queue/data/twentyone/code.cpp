@@ -0,0 +1,159 @@
+#include <iostream>
+#include <string>
+
+#include "persistent_heap.hpp"
+#include "priority_queue.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+// counts live copies, to see what versions share
+long long live = 0;
+
+struct Counted {
+    int value;
+    Counted(int value) : value(value) {
+        live++;
+    }
+    Counted(const Counted &other) : value(other.value) {
+        live++;
+    }
+    ~Counted() {
+        live--;
+    }
+    bool operator<(const Counted &other) const {
+        return value < other.value;
+    }
+};
+
+typedef sjtu::persistent_heap<Counted> heap;
+
+bool same(heap h, sjtu::priority_queue<int> q) {
+    if (h.size() != q.size()) return false;
+    while (!q.empty()) {
+        if (h.top().value != q.top()) return false;
+        h = h.pop();
+        q.pop();
+    }
+    return h.empty();
+}
+
+// A tree of versions, each made from a random earlier one, against deep
+// copies of a plain queue; every version must still hold what it did.
+bool versions_stay_intact() {
+    const int N = 400;
+    static heap versions[N];
+    static sjtu::priority_queue<int> reference[N];
+    for (int i = 1; i < N; i++) {
+        int from = Rand() % i;
+        int op = Rand() % 4;
+        reference[i] = reference[from];
+        if (op < 2 || versions[from].empty()) {
+            int value = Rand() % 1000;
+            versions[i] = versions[from].push(Counted(value));
+            reference[i].push(value);
+        } else if (op == 2) {
+            versions[i] = versions[from].pop();
+            reference[i].pop();
+        } else {
+            int other = Rand() % i;
+            versions[i] = versions[from].merge(versions[other]);
+            sjtu::priority_queue<int> copy(reference[other]);
+            reference[i].merge(copy);
+        }
+    }
+    for (int i = 0; i < N; i++) {
+        if (!same(versions[i], reference[i])) return false;
+    }
+    for (int i = 0; i < N; i++) versions[i] = heap();
+    return live == 0;
+}
+
+// Thousands of siblings of one large state cost memory per change.
+bool siblings_share() {
+    heap base;
+    for (int i = 0; i < 10000; i++) base = base.push(Counted(Rand()));
+    long long before = live;
+    static heap siblings[2000];
+    for (int i = 0; i < 2000; i++) {
+        siblings[i] = (i % 2 ? base.push(Counted(Rand())) : base.pop());
+    }
+    // each sibling copies one or two right spines of at most 14 nodes
+    bool shared = live - before < 2000 * 30;
+    for (int i = 0; i < 2000; i++) siblings[i] = heap();
+    bool freed = live == before;
+    base = heap();
+    return shared && freed && live == 0;
+}
+
+// Freeing a long left spine must not recurse.
+bool frees_deep_heaps() {
+    {
+        heap h;
+        for (int i = 0; i < 1000000; i++) h = h.push(Counted(i));
+        heap snapshot = h;
+        for (int i = 0; i < 10; i++) h = h.pop();
+        if (snapshot.top().value != 999999 || h.top().value != 999989) {
+            return false;
+        }
+    }
+    return live == 0;
+}
+
+int countdown = -1;
+
+struct FaultyCompare {
+    bool operator()(const Counted &a, const Counted &b) const {
+        if (countdown >= 0 && countdown-- == 0) throw sjtu::runtime_error();
+        return a.value < b.value;
+    }
+};
+
+// A throwing comparison changes no version and leaks nothing.
+bool survives_throws() {
+    typedef sjtu::persistent_heap<Counted, FaultyCompare> faulty;
+    faulty a, b;
+    for (int i = 0; i < 200; i++) {
+        a = a.push(Counted(Rand() % 1000));
+        b = b.push(Counted(Rand() % 1000));
+    }
+    long long before = live;
+    for (int fail_at = 0; fail_at < 20; fail_at++) {
+        for (int op = 0; op < 3; op++) {
+            countdown = fail_at;
+            try {
+                faulty c = op == 0 ? a.push(Counted(500))
+                                   : op == 1 ? a.pop() : a.merge(b);
+            } catch (sjtu::runtime_error &) {
+            }
+            countdown = -1;
+            if (live != before || a.size() != 200 || b.size() != 200) {
+                return false;
+            }
+        }
+    }
+    faulty c = a.merge(b);
+    int previous = 1000, count = 0;
+    while (!c.empty()) {
+        if (c.top().value > previous) return false;
+        previous = c.top().value;
+        c = c.pop();
+        count++;
+    }
+    return count == 400;
+}
+
+int main() {
+    std::cout << (versions_stay_intact() ? "ok" : "mismatch") << std::endl;
+    std::cout << (siblings_share() ? "ok" : "mismatch") << std::endl;
+    std::cout << (frees_deep_heaps() ? "ok" : "mismatch") << std::endl;
+    std::cout << (survives_throws() ? "ok" : "mismatch") << std::endl;
+    sjtu::persistent_heap<std::string, std::greater<std::string>> words;
+    sjtu::persistent_heap<std::string, std::greater<std::string>> more =
+        words.push("b").push("a").push("c");
+    std::cout << words.size() << " " << more.top() << " " << more.pop().top()
+              << std::endl;
+    return 0;
+}
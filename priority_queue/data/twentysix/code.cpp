@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "priority_queue.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+int countdown = -1;
+
+struct FaultyCompare {
+    bool operator()(int a, int b) const {
+        if (countdown >= 0 && countdown-- == 0) throw sjtu::runtime_error();
+        return a < b;
+    }
+};
+
+typedef sjtu::priority_queue<int, FaultyCompare> queue;
+
+// whether q holds exactly the elements of expected, sorted greatest first
+bool holds(queue q, const std::vector<int> &expected) {
+    if (q.size() != expected.size()) return false;
+    for (int x : expected) {
+        if (q.empty() || q.top() != x) return false;
+        q.pop();
+    }
+    return q.empty();
+}
+
+std::vector<int> sorted(std::vector<int> v) {
+    std::sort(v.begin(), v.end(), std::greater<int>());
+    return v;
+}
+
+// Pushing i and -i in turn, ending on a negative one, leaves a right spine of
+// half the elements, so merges walk far past the path kept inline.
+void fill_alternating(queue &q, std::vector<int> &values, int n, int shift) {
+    for (int i = 0; i < n; i++) {
+        int x = i % 2 ? i + shift : -i - shift;
+        q.push(x);
+        values.push_back(x);
+    }
+}
+
+// A comparison failing anywhere along a merge leaves both queues as they
+// were; the same merge then succeeds.
+bool survives_long_merges() {
+    queue a, b;
+    std::vector<int> in_a, in_b;
+    fill_alternating(a, in_a, 20001, 0);
+    fill_alternating(b, in_b, 20001, 1);
+    std::vector<int> both = in_a;
+    both.insert(both.end(), in_b.begin(), in_b.end());
+    in_a = sorted(in_a);
+    in_b = sorted(in_b);
+    both = sorted(both);
+    const int fail_at[] = {0, 1, 63, 64, 65, 4095, 4096, 4097, 9000, 19999};
+    int threw = 0;
+    for (int f : fail_at) {
+        queue x = a, y = b;
+        countdown = f;
+        try {
+            x.merge(y);
+        } catch (sjtu::runtime_error &) {
+            threw++;
+            countdown = -1;
+            if (!holds(x, in_a) || !holds(y, in_b)) return false;
+            x.merge(y);
+        }
+        countdown = -1;
+        if (!holds(x, both) || !y.empty()) return false;
+    }
+    return threw == 10;
+}
+
+// The same for pop, which merges the two subtrees of the top.
+bool survives_long_pops() {
+    queue q;
+    std::vector<int> values;
+    fill_alternating(q, values, 40001, 0);
+    values = sorted(values);
+    std::vector<int> rest(values.begin() + 1, values.end());
+    const int fail_at[] = {0, 64, 65, 4096, 4097, 15000};
+    for (int f : fail_at) {
+        queue copy = q;
+        countdown = f;
+        bool threw = false;
+        try {
+            copy.pop();
+        } catch (sjtu::runtime_error &) {
+            threw = true;
+        }
+        countdown = -1;
+        if (!threw || !holds(copy, values)) return false;
+        copy.pop();
+        if (!holds(copy, rest)) return false;
+    }
+    return true;
+}
+
+// Random merges of queues of every size, with comparisons failing now and
+// then, against sorted arrays.
+bool matches_reference() {
+    const int K = 8;
+    queue q[K];
+    std::vector<int> v[K];
+    for (int step = 0; step < 3000; step++) {
+        int i = Rand() % K, j = Rand() % K;
+        int op = Rand() % 4;
+        if (op < 2) {
+            int n = Rand() % 200;
+            for (int t = 0; t < n; t++) {
+                int x = Rand();
+                q[i].push(x);
+                v[i].push_back(x);
+            }
+        } else if (op == 2 && i != j) {
+            if (Rand() % 3 == 0) countdown = Rand() % 300;
+            try {
+                q[i].merge(q[j]);
+                v[i].insert(v[i].end(), v[j].begin(), v[j].end());
+                v[j].clear();
+            } catch (sjtu::runtime_error &) {
+            }
+            countdown = -1;
+        } else if (!v[i].empty()) {
+            v[i] = sorted(v[i]);
+            if (q[i].top() != v[i][0]) return false;
+            q[i].pop();
+            v[i].erase(v[i].begin());
+        }
+    }
+    for (int i = 0; i < K; i++) {
+        if (!holds(q[i], sorted(v[i]))) return false;
+    }
+    return true;
+}
+
+int main() {
+    std::cout << (survives_long_merges() ? "ok" : "mismatch") << std::endl;
+    std::cout << (survives_long_pops() ? "ok" : "mismatch") << std::endl;
+    std::cout << (matches_reference() ? "ok" : "mismatch") << std::endl;
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include "calendar_queue.hpp"
+#include "priority_queue.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+typedef sjtu::priority_queue<double, std::greater<double>> reference_queue;
+
+// The hold model of event simulation: take the earliest event and schedule
+// one a random time after it, against a plain min-queue.
+bool holds_match(double (*increment)()) {
+    sjtu::calendar_queue<double> q;
+    reference_queue reference;
+    for (int i = 0; i < 5000; i++) {
+        double t = increment();
+        q.push(t);
+        reference.push(t);
+    }
+    for (int step = 0; step < 300000; step++) {
+        if (q.size() != reference.size() || q.top() != reference.top()) {
+            return false;
+        }
+        double now = q.pop_value();
+        reference.pop();
+        int op = Rand() % 10;
+        // mostly hold, sometimes grow or shrink the population
+        for (int k = op < 8 ? 1 : op == 8 ? 2 : 0; k > 0; k--) {
+            double t = now + increment();
+            q.push(t);
+            reference.push(t);
+        }
+        if (q.empty()) {
+            q.push(now);
+            reference.push(now);
+        }
+    }
+    while (!q.empty()) {
+        if (q.top() != reference.top()) return false;
+        q.pop();
+        reference.pop();
+    }
+    return reference.empty();
+}
+
+double uniform() {
+    return Rand() % 1000 / 10.0;
+}
+
+double exponential_like() {
+    int r = Rand() % 1000;
+    return r * r * r / 1e7;
+}
+
+// clustered times far apart, with ties
+double bimodal() {
+    return Rand() % 2 ? Rand() % 4 : 1e9 + Rand() % 100;
+}
+
+// Growing to a million events and draining them resizes all the way up
+// and down; times may be negative.
+bool grows_and_shrinks() {
+    sjtu::calendar_queue<long long> q;
+    for (int i = 0; i < 1000000; i++) q.push((long long)Rand() - 500000);
+    long long previous = -1000000;
+    size_t count = 0;
+    while (!q.empty()) {
+        if (q.top() < previous) return false;
+        previous = q.top();
+        q.pop();
+        count++;
+    }
+    return count == 1000000;
+}
+
+struct Event {
+    double time;
+    std::string name;
+};
+
+struct TimeOfEvent {
+    double operator()(const Event &e) const {
+        return e.time;
+    }
+};
+
+int main() {
+    std::cout << (holds_match(uniform) ? "ok" : "mismatch") << std::endl;
+    std::cout << (holds_match(exponential_like) ? "ok" : "mismatch")
+              << std::endl;
+    std::cout << (holds_match(bimodal) ? "ok" : "mismatch") << std::endl;
+    std::cout << (grows_and_shrinks() ? "ok" : "mismatch") << std::endl;
+
+    sjtu::calendar_queue<Event, TimeOfEvent> events;
+    events.push(Event{2.5, "arrive"});
+    events.push(Event{0.5, "open"});
+    events.emplace(Event{9.0, "close"});
+    sjtu::calendar_queue<Event, TimeOfEvent> copy(events), assigned;
+    assigned = events;
+    events.pop();
+    std::cout << events.top().name << " " << copy.top().name << " "
+              << copy.size() << " " << assigned.pop_value().name << std::endl;
+    try {
+        sjtu::calendar_queue<int>().top();
+    } catch (sjtu::container_is_empty &) {
+        std::cout << "empty" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include <cstdint>
+#include <iostream>
+
+#include "timing_wheel.hpp"
+
+int A = 325, B = 2336, last = 233, mod = 1000007;
+int Rand() {
+    return last = (A * last + B) % mod;
+}
+
+struct Timer {
+    std::uint64_t deadline;
+    int priority;
+    int id;
+};
+
+struct ByPriority {
+    bool operator()(const Timer &a, const Timer &b) const {
+        return a.priority < b.priority;
+    }
+};
+
+typedef sjtu::timing_wheel<Timer, ByPriority> wheel;
+
+// whether a fires before b, as the wheel should order them
+bool before(const Timer &a, const Timer &b) {
+    if (a.deadline != b.deadline) return a.deadline < b.deadline;
+    return a.priority > b.priority;
+}
+
+std::uint64_t random_delay() {
+    switch (Rand() % 6) {
+        case 0:
+            return Rand() % 64;
+        case 1:
+            return Rand() % 5000;
+        case 2:
+            return (std::uint64_t)Rand() << 12;
+        case 3:
+            return (std::uint64_t)Rand() << 30;
+        case 4:
+            return ((std::uint64_t)(Rand() % 1024) << 40) + Rand();
+        default:
+            return 0;
+    }
+}
+
+// Random schedules, cancels, reschedules and advances of every size,
+// against a plain array scanned for what is due.
+bool matches_brute_force() {
+    const int N = 2000;
+    static Timer pending[N];
+    static wheel::handle handles[N];
+    static Timer fired[N];
+    int size = 0, next_id = 0;
+    wheel w(12345);
+    for (int step = 0; step < 30000; step++) {
+        int op = Rand() % 10;
+        if (op < 5 && size < N) {
+            std::uint64_t deadline = w.now() + random_delay();
+            if (Rand() % 20 == 0) deadline = w.now() - Rand() % 100;
+            Timer t{deadline, Rand() % 3, next_id++};
+            handles[size] = w.schedule(deadline, t);
+            pending[size++] = t;
+        } else if (op < 7 && size > 0) {
+            int at = Rand() % size;
+            if (w.get(handles[at]).id != pending[at].id) return false;
+            w.cancel(handles[at]);
+            pending[at] = pending[--size];
+            handles[at] = handles[size];
+        } else if (op < 8 && size > 0) {
+            int at = Rand() % size;
+            pending[at].deadline = w.now() + random_delay();
+            w.reschedule(handles[at], pending[at].deadline);
+            if (w.deadline(handles[at]) != pending[at].deadline) return false;
+        } else {
+            std::uint64_t to = w.now() + random_delay();
+            Timer *end = w.advance(to, fired);
+            if (w.now() != to) return false;
+            // the fired timers, in order, then the rest still pending; a
+            // payload keeps its first deadline, so look up the current one
+            Timer previous{0, 0, -1};
+            for (Timer *t = fired; t != end; ++t) {
+                int at = 0;
+                while (at < size && pending[at].id != t->id) at++;
+                if (at == size) return false;
+                Timer current = pending[at];
+                if (current.deadline > to) return false;
+                if (previous.id >= 0 && before(current, previous)) return false;
+                previous = current;
+                pending[at] = pending[--size];
+                handles[at] = handles[size];
+            }
+            for (int i = 0; i < size; i++) {
+                if (pending[i].deadline <= to) return false;
+            }
+        }
+        if ((int)w.size() != size) return false;
+    }
+    return true;
+}
+
+// Timers due at one tick fire greatest first; overdue ones first of all.
+bool orders_ticks() {
+    wheel w(1000);
+    for (int i = 0; i < 100; i++) {
+        w.schedule(5000, Timer{5000, Rand() % 1000, i});
+    }
+    w.schedule(10, Timer{10, 0, 100});
+    static Timer fired[101];
+    Timer *end = w.advance(4999, fired);
+    if (end != fired + 1 || fired[0].id != 100) return false;
+    end = w.advance(5000, fired);
+    if (end != fired + 100) return false;
+    for (int i = 1; i < 100; i++) {
+        if (fired[i].priority > fired[i - 1].priority) return false;
+    }
+    if (!w.empty()) return false;
+    // deadlines on the highest level
+    const std::uint64_t top = ~(std::uint64_t)0;
+    wheel far(top / 2);
+    far.schedule(top, Timer{top, 0, 0});
+    far.schedule(top / 2 + 70, Timer{top / 2 + 70, 0, 1});
+    end = far.advance(top, fired);
+    return end == fired + 2 && fired[0].id == 1 && fired[1].id == 0 &&
+           far.empty();
+}
+
+int countdown = -1;
+
+struct FaultyCompare {
+    bool operator()(const Timer &a, const Timer &b) const {
+        if (countdown >= 0 && countdown-- == 0) throw sjtu::runtime_error();
+        return a.priority < b.priority;
+    }
+};
+
+// records what advance writes, even when it throws
+Timer written[64];
+int written_count = 0;
+
+struct Sink {
+    Sink &operator*() {
+        return *this;
+    }
+    Sink &operator++() {
+        return *this;
+    }
+    Sink &operator=(const Timer &t) {
+        written[written_count++] = t;
+        return *this;
+    }
+};
+
+// A comparison failing while a tick is ordered leaves its timers pending:
+// they fire, in order, on the next advance.
+bool survives_throws() {
+    for (int fail_at = 0; fail_at < 200; fail_at++) {
+        sjtu::timing_wheel<Timer, FaultyCompare> w;
+        for (int i = 0; i < 30; i++) {
+            std::uint64_t deadline = 100 + i % 2;
+            w.schedule(deadline, Timer{deadline, Rand() % 5, i});
+        }
+        written_count = 0;
+        countdown = fail_at;
+        bool threw = false;
+        try {
+            w.advance(200, Sink());
+        } catch (sjtu::runtime_error &) {
+            threw = true;
+        }
+        countdown = -1;
+        if (written_count + (int)w.size() != 30) return false;
+        if (threw) w.advance(200, Sink());
+        if (written_count != 30 || !w.empty()) return false;
+        bool seen[30] = {};
+        for (int i = 0; i < 30; i++) {
+            if (seen[written[i].id]) return false;
+            seen[written[i].id] = true;
+            if (i > 0 && before(written[i], written[i - 1])) return false;
+        }
+    }
+    return true;
+}
+
+int main() {
+    std::cout << (matches_brute_force() ? "ok" : "mismatch") << std::endl;
+    std::cout << (orders_ticks() ? "ok" : "mismatch") << std::endl;
+    std::cout << (survives_throws() ? "ok" : "mismatch") << std::endl;
+    return 0;
+}
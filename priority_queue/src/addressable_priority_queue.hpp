@@ -0,0 +1,596 @@
+#ifndef SJTU_ADDRESSABLE_PRIORITY_QUEUE_HPP
+#define SJTU_ADDRESSABLE_PRIORITY_QUEUE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+
+namespace sjtu {
+/**
+ * @brief a priority queue whose elements can be reached after insertion.
+ * push returns a handle that stays valid until that element is popped or
+ * erased (also across merge), so a key can be changed in place instead of
+ * pushing a duplicate and skipping the stale copy later.
+ *
+ * It is a pairing heap: push, top, merge and increase_key are O(1), pop,
+ * erase and decrease_key O(log n) amortized.
+ *
+ * Keys are ordered by Compare as in priority_queue: the top is an element no
+ * other element compares greater than. increase_key moves an element toward
+ * the top, decrease_key away from it, and update works either way. So for a
+ * Dijkstra queue ordered by std::greater<>, lowering a distance is an
+ * increase_key.
+ *
+ * **Exception Safety**: if `Compare` throws, the operation is abandoned and
+ * runtime_error is thrown; the queue keeps exactly the elements and keys it
+ * had before (its internal shape may differ), and every handle stays valid.
+ */
+template <typename T, class Compare = std::less<T>>
+class addressable_priority_queue {
+   private:
+    struct Node {
+        T data;
+        Node* child;
+        Node* next;
+        // the parent if this is the first child, the previous sibling
+        // otherwise; nullptr for the root
+        Node* prev;
+
+        template <class... Args>
+        explicit Node(Args&&... args)
+            : data(std::forward<Args>(args)...),
+              child(nullptr),
+              next(nullptr),
+              prev(nullptr) {
+        }
+    };
+
+    typedef node_pool<Node> pool_type;
+
+    Node* root;
+    size_t _size;
+    pool_type* pool;
+    // takes no space when Compare is empty
+    [[no_unique_address]] Compare cmp;
+
+    pool_type* node_source() {
+        if (!pool) pool = pool_type::create();
+        return pool_type::find(pool);
+    }
+
+    template <class... Args>
+    Node* create_node(Args&&... args) {
+        pool_type* source = node_source();
+        void* memory = source->allocate();
+        try {
+            return new (memory) Node(std::forward<Args>(args)...);
+        } catch (...) {
+            source->deallocate(memory);
+            throw;
+        }
+    }
+
+    void destroy_node(Node* node) {
+        node->~Node();
+        pool_type::find(pool)->deallocate(node);
+    }
+
+    /**
+     * @brief destroy a tree in O(1) extra space, reading child as the left
+     * and next as the right link of a binary tree.
+     */
+    void clear(Node*& node, bool recycle = true) {
+        Node* cur = node;
+        while (cur) {
+            if (cur->child) {
+                Node* child = cur->child;
+                cur->child = child->next;
+                child->next = cur;
+                cur = child;
+            } else {
+                Node* next = cur->next;
+                if (recycle) {
+                    destroy_node(cur);
+                } else {
+                    cur->~Node();
+                }
+                cur = next;
+            }
+        }
+        node = nullptr;
+    }
+
+    void release() {
+        if (!pool) return;
+        if (!pool_type::find(pool)->is_exclusive()) {
+            clear(root);
+        } else if constexpr (!std::is_trivially_destructible_v<T>) {
+            clear(root, false);
+        }
+        root = nullptr;
+        pool_type::release(pool);
+        pool = nullptr;
+    }
+
+    /**
+     * @brief copy the tree of b without recursion, walking both trees in
+     * step and climbing back through the prev links.
+     */
+    Node* copy(Node* b) {
+        if (!b) return nullptr;
+        Node* a = create_node(b->data);
+        try {
+            Node* s = b;
+            Node* d = a;
+            while (true) {
+                if (s->child) {
+                    Node* c = create_node(s->child->data);
+                    d->child = c;
+                    c->prev = d;
+                    s = s->child;
+                    d = c;
+                    continue;
+                }
+                while (s != b && !s->next) {
+                    while (s->prev->child != s) {
+                        s = s->prev;
+                        d = d->prev;
+                    }
+                    s = s->prev;
+                    d = d->prev;
+                }
+                if (s == b) break;
+                Node* n = create_node(s->next->data);
+                d->next = n;
+                n->prev = d;
+                s = s->next;
+                d = n;
+            }
+        } catch (...) {
+            clear(a);
+            throw;
+        }
+        return a;
+    }
+
+    /**
+     * @brief detach node (and its subtree) from its parent or siblings.
+     */
+    static void cut(Node* node) {
+        if (!node->prev) return;
+        if (node->prev->child == node) {
+            node->prev->child = node->next;
+        } else {
+            node->prev->next = node->next;
+        }
+        if (node->next) node->next->prev = node->prev;
+        node->prev = node->next = nullptr;
+    }
+
+    /**
+     * @brief make b the first child of a.
+     */
+    static void adopt(Node* a, Node* b) {
+        b->next = a->child;
+        if (a->child) a->child->prev = b;
+        a->child = b;
+        b->prev = a;
+    }
+
+    /**
+     * @brief meld two detached trees. The single comparison happens before
+     * any link changes, so a throw leaves both trees as they were.
+     */
+    Node* meld(Node* a, Node* b) const {
+        if (!a) return b;
+        if (!b) return a;
+        if (cmp(a->data, b->data)) std::swap(a, b);
+        adopt(a, b);
+        return a;
+    }
+
+    /**
+     * @brief hang every tree of the sibling list first under parent.
+     * parent must compare no lower than any of them.
+     */
+    static void adopt_all(Node* parent, Node* first) {
+        while (first) {
+            Node* next = first->next;
+            first->prev = first->next = nullptr;
+            adopt(parent, first);
+            first = next;
+        }
+    }
+
+    /**
+     * @brief two-pass pairing of a detached sibling list into one tree.
+     * If Compare throws, every tree touched so far is threaded back into a
+     * sibling list returned through first, and the exception is rethrown.
+     */
+    Node* combine(Node*& first) const {
+        if (!first) return nullptr;
+        first->prev = nullptr;
+        // pass 1: meld pairs left to right, collecting them in reverse
+        Node* pairs = nullptr;
+        Node* rest = first;
+        try {
+            while (rest) {
+                Node* a = rest;
+                Node* b = a->next;
+                rest = b ? b->next : nullptr;
+                a->next = a->prev = nullptr;
+                if (b) {
+                    b->next = b->prev = nullptr;
+                    try {
+                        a = meld(a, b);
+                    } catch (...) {
+                        a->next = b;
+                        b->next = rest;
+                        rest = a;
+                        throw;
+                    }
+                }
+                a->next = pairs;
+                pairs = a;
+            }
+            // pass 2: fold the pairs right to left
+            Node* tree = pairs;
+            pairs = pairs->next;
+            tree->next = nullptr;
+            while (pairs) {
+                Node* next = pairs->next;
+                pairs->next = nullptr;
+                try {
+                    tree = meld(pairs, tree);
+                } catch (...) {
+                    pairs->next = next;
+                    tree->next = pairs;
+                    rest = tree;
+                    pairs = nullptr;
+                    throw;
+                }
+                pairs = next;
+            }
+            return tree;
+        } catch (...) {
+            // splice whatever pass 1 already produced in front of the rest
+            while (pairs) {
+                Node* next = pairs->next;
+                pairs->next = rest;
+                rest = pairs;
+                pairs = next;
+            }
+            first = rest;
+            throw;
+        }
+    }
+
+   public:
+    /**
+     * @brief refers to one element of the queue; default-constructed handles
+     * refer to nothing.
+     */
+    class handle {
+       private:
+        Node* node;
+        friend class addressable_priority_queue;
+        explicit handle(Node* node) : node(node) {
+        }
+
+       public:
+        handle() : node(nullptr) {
+        }
+        bool operator==(const handle& rhs) const {
+            return node == rhs.node;
+        }
+        bool operator!=(const handle& rhs) const {
+            return node != rhs.node;
+        }
+    };
+
+    /**
+     * @brief default constructor
+     */
+    addressable_priority_queue()
+        : root(nullptr), _size(0), pool(nullptr), cmp() {
+    }
+
+    /**
+     * @brief an empty queue ordered by a copy of compare, which may carry
+     * state.
+     */
+    explicit addressable_priority_queue(const Compare& compare)
+        : root(nullptr), _size(0), pool(nullptr), cmp(compare) {
+    }
+
+    /**
+     * @brief copy constructor. Handles into other do not refer to the copy.
+     */
+    addressable_priority_queue(const addressable_priority_queue& other)
+        : root(nullptr), _size(0), pool(nullptr), cmp(other.cmp) {
+        try {
+            root = copy(other.root);
+        } catch (...) {
+            release();
+            throw;
+        }
+        _size = other._size;
+    }
+
+    /**
+     * @brief deconstructor
+     */
+    ~addressable_priority_queue() {
+        release();
+    }
+
+    /**
+     * @brief Assignment operator
+     */
+    addressable_priority_queue& operator=(
+        const addressable_priority_queue& other) {
+        if (this == &other) return *this;
+        clear(root);
+        _size = 0;
+        root = copy(other.root);
+        _size = other._size;
+        cmp = other.cmp;
+        return *this;
+    }
+
+    /**
+     * @brief get the top element of the priority queue.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& top() const {
+        if (empty()) throw container_is_empty();
+        return root->data;
+    }
+
+    /**
+     * @brief the handle of the top element.
+     * @throws container_is_empty if empty() returns true
+     */
+    handle top_handle() const {
+        if (empty()) throw container_is_empty();
+        return handle(root);
+    }
+
+    /**
+     * @brief the current key of the element h refers to.
+     */
+    const T& get(handle h) const {
+        return h.node->data;
+    }
+
+    /**
+     * @brief push new element to the priority queue.
+     * @return a handle to the new element.
+     */
+    handle push(const T& e) {
+        return emplace(e);
+    }
+
+    /**
+     * @brief push an element, moving from e.
+     */
+    handle push(T&& e) {
+        return emplace(std::move(e));
+    }
+
+    /**
+     * @brief push an element constructed in place from args.
+     */
+    template <class... Args>
+    handle emplace(Args&&... args) {
+        Node* node = create_node(std::forward<Args>(args)...);
+        try {
+            root = meld(root, node);
+        } catch (...) {
+            destroy_node(node);
+            throw runtime_error();
+        }
+        _size++;
+        return handle(node);
+    }
+
+    /**
+     * @brief delete the top element from the priority queue.
+     * @throws container_is_empty if empty() returns true
+     */
+    void pop() {
+        if (empty()) throw container_is_empty();
+        Node* old = root;
+        Node* children = old->child;
+        old->child = nullptr;
+        try {
+            root = combine(children);
+        } catch (...) {
+            adopt_all(old, children);
+            throw runtime_error();
+        }
+        destroy_node(old);
+        _size--;
+    }
+
+    /**
+     * @brief remove the top element and return it, moved out rather than
+     * copied (unless T can only be moved by a throwing constructor).
+     * @throws container_is_empty if empty() returns true
+     */
+    T pop_value() {
+        if (empty()) throw container_is_empty();
+        Node* old = root;
+        Node* children = old->child;
+        old->child = nullptr;
+        Node* rest;
+        try {
+            rest = combine(children);
+        } catch (...) {
+            adopt_all(old, children);
+            throw runtime_error();
+        }
+        // old stays on top of the paired children until its value is out
+        if (rest) adopt(old, rest);
+        T value(std::move_if_noexcept(old->data));
+        if (rest) cut(rest);
+        root = rest;
+        destroy_node(old);
+        _size--;
+        return value;
+    }
+
+    /**
+     * @brief remove the element h refers to; h becomes invalid.
+     */
+    void erase(handle h) {
+        Node* node = h.node;
+        if (node == root) {
+            pop();
+            return;
+        }
+        cut(node);
+        Node* children = node->child;
+        node->child = nullptr;
+        Node* merged;
+        try {
+            merged = combine(children);
+        } catch (...) {
+            adopt_all(node, children);
+            adopt(root, node);
+            throw runtime_error();
+        }
+        // the subtree came from below the root, so no comparison is needed
+        if (merged) adopt(root, merged);
+        destroy_node(node);
+        _size--;
+    }
+
+    /**
+     * @brief raise the key of h to e, which must compare no lower than the
+     * current key (toward the top). O(1).
+     */
+    void increase_key(handle h, const T& e) {
+        Node* node = h.node;
+        T key(e);
+        using std::swap;
+        swap(node->data, key);
+        if (node == root) return;
+        cut(node);
+        try {
+            root = meld(root, node);
+        } catch (...) {
+            swap(node->data, key);
+            adopt(root, node);
+            throw runtime_error();
+        }
+    }
+
+    /**
+     * @brief lower the key of h to e, which must compare no higher than the
+     * current key (away from the top). O(log n) amortized.
+     */
+    void decrease_key(handle h, const T& e) {
+        Node* node = h.node;
+        T key(e);
+        bool was_root = node == root;
+        if (!was_root) cut(node);
+        Node* children = node->child;
+        node->child = nullptr;
+        Node* merged;
+        try {
+            merged = combine(children);
+        } catch (...) {
+            adopt_all(node, children);
+            if (!was_root) adopt(root, node);
+            throw runtime_error();
+        }
+        using std::swap;
+        swap(node->data, key);
+        if (!was_root) {
+            // both the children and the lowered key stay below the root
+            if (merged) adopt(root, merged);
+            adopt(root, node);
+            return;
+        }
+        try {
+            root = meld(merged, node);
+        } catch (...) {
+            swap(node->data, key);
+            if (merged) adopt(node, merged);
+            throw runtime_error();
+        }
+    }
+
+    /**
+     * @brief set the key of h to e in whichever direction it moves.
+     */
+    void update(handle h, const T& e) {
+        bool lower;
+        try {
+            lower = cmp(e, h.node->data);
+        } catch (...) {
+            throw runtime_error();
+        }
+        if (lower) {
+            decrease_key(h, e);
+        } else {
+            increase_key(h, e);
+        }
+    }
+
+    /**
+     * @brief return the number of elements in the priority queue.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @brief check if the container is empty.
+     */
+    bool empty() const {
+        return _size == 0;
+    }
+
+    /**
+     * @brief a copy of the comparator that orders the queue.
+     */
+    Compare value_comp() const {
+        return cmp;
+    }
+
+    /**
+     * @brief merge another queue into this one in O(1); other is left
+     * empty and its handles now refer to elements of this queue. Both
+     * queues must order elements the same way.
+     */
+    void merge(addressable_priority_queue& other) {
+        if (this == &other || !other.root) return;
+        if (!pool) {
+            pool = pool_type::find(other.pool);
+            pool->retain();
+        } else if (pool_type::find(pool) != pool_type::find(other.pool)) {
+            pool_type::find(pool)->unite(pool_type::find(other.pool));
+        }
+        try {
+            root = meld(root, other.root);
+        } catch (...) {
+            throw runtime_error();
+        }
+        _size += other._size;
+        other.root = nullptr;
+        other._size = 0;
+        pool_type::release(other.pool);
+        other.pool = nullptr;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
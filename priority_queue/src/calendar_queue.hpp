@@ -0,0 +1,537 @@
+#ifndef SJTU_CALENDAR_QUEUE_HPP
+#define SJTU_CALENDAR_QUEUE_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "exceptions.hpp"
+
+namespace sjtu {
+/**
+ * @brief the time of an element of a calendar_queue; arithmetic elements
+ * are their own time. Pass another functor for event structs.
+ */
+template <class T, class = void>
+struct calendar_time;
+
+template <class T>
+struct calendar_time<T, std::enable_if_t<std::is_arithmetic_v<T>>> {
+    T operator()(const T& e) const {
+        return e;
+    }
+};
+
+/**
+ * @brief a min-queue of events for discrete-event simulation, with O(1)
+ * expected push and pop when event times are spread evenly: top() is the
+ * event with the earliest time.
+ *
+ * This is Brown's calendar queue. Time is cut into days of a fixed width,
+ * and day d is filed in bucket d mod the number of buckets, like the days
+ * of a year on a desk calendar. pop() serves the current day's bucket and
+ * moves on one bucket, one day, at a time; a whole year without an event
+ * jumps straight to the earliest one. The number of buckets doubles or
+ * halves with the number of events, and the day width is re-estimated then
+ * from the gaps between the earliest events, so a bucket holds about one
+ * event of the current year. When the times drift while the number of
+ * events holds steady and pops start scanning many days or events each,
+ * the width is re-estimated as well.
+ *
+ * Buckets are plain growable arrays that keep their storage, so a steady
+ * workload stops allocating.
+ *
+ * TimeOf maps an element to an arithmetic time and must not throw; times
+ * must be finite.
+ *
+ * **Exception Safety**: if copying or moving an element throws while the
+ * calendar is resized, the old calendar is kept and the operation throws
+ * without effect.
+ */
+template <typename T, class TimeOf = calendar_time<T>>
+class calendar_queue {
+   private:
+    typedef std::decay_t<decltype(std::declval<const TimeOf&>()(
+        std::declval<const T&>()))>
+        time_type;
+
+    // how many of the earliest events the day width is estimated from
+    static const size_t sample_size = 32;
+
+    // a growable array that keeps its storage when emptied
+    struct bucket {
+        T* items;
+        size_t size;
+        size_t capacity;
+    };
+
+    bucket* buckets;
+    // a power of two, or zero before the first push
+    size_t bucket_count;
+    double width;
+    // the day being served: no event is earlier
+    mutable long long today;
+    // where top() found the earliest event, until the queue changes
+    mutable bucket* top_bucket;
+    mutable size_t top_index;
+    // days and events locate() looked at, and pops made, since the day
+    // width was last estimated
+    mutable size_t effort;
+    size_t served;
+    // how many times over effort must pay for an estimate, doubled each
+    // time one changes nothing
+    size_t patience;
+    size_t _size;
+    [[no_unique_address]] TimeOf time_of;
+
+    static T* allocate(size_t n) {
+        return static_cast<T*>(
+            operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    static void deallocate(T* p) {
+        if (p) operator delete(p, std::align_val_t(alignof(T)));
+    }
+
+    /**
+     * @brief grow b to hold at least n items; b is unchanged on failure.
+     */
+    static void reserve(bucket& b, size_t n) {
+        if (n <= b.capacity) return;
+        size_t grown = b.capacity < 4 ? 4 : b.capacity * 2;
+        if (grown < n) grown = n;
+        T* fresh = allocate(grown);
+        size_t built = 0;
+        try {
+            for (; built < b.size; ++built) {
+                new (fresh + built) T(std::move_if_noexcept(b.items[built]));
+            }
+        } catch (...) {
+            for (size_t i = 0; i < built; ++i) fresh[i].~T();
+            deallocate(fresh);
+            throw;
+        }
+        for (size_t i = 0; i < b.size; ++i) b.items[i].~T();
+        deallocate(b.items);
+        b.items = fresh;
+        b.capacity = grown;
+    }
+
+    static void free_buckets(bucket* bs, size_t n) {
+        if (!bs) return;
+        for (size_t j = 0; j < n; ++j) {
+            for (size_t i = 0; i < bs[j].size; ++i) bs[j].items[i].~T();
+            deallocate(bs[j].items);
+        }
+        delete[] bs;
+    }
+
+    static long long day_of(time_type t, double w) {
+        return static_cast<long long>(std::floor(static_cast<double>(t) / w));
+    }
+
+    long long day_of(const T& e) const {
+        return day_of(time_of(e), width);
+    }
+
+    bucket& bucket_of(long long day) const {
+        return buckets[static_cast<size_t>(day) & (bucket_count - 1)];
+    }
+
+    /**
+     * @brief set today to the day of the earliest event by a full search.
+     */
+    void locate_earliest() const {
+        top_bucket = nullptr;
+        effort += _size;
+        for (size_t j = 0; j < bucket_count; ++j) {
+            bucket& b = buckets[j];
+            for (size_t i = 0; i < b.size; ++i) {
+                if (!top_bucket ||
+                    time_of(b.items[i]) < time_of(top_bucket->items[top_index])) {
+                    top_bucket = &b;
+                    top_index = i;
+                }
+            }
+        }
+        today = day_of(top_bucket->items[top_index]);
+    }
+
+    /**
+     * @brief find the earliest event: scan the buckets from today's for
+     * one holding an event of its own day this year, or failing that,
+     * search every bucket.
+     */
+    void locate() const {
+        if (top_bucket) return;
+        for (size_t k = 0; k < bucket_count; ++k) {
+            long long day = today + static_cast<long long>(k);
+            bucket& b = bucket_of(day);
+            effort += 1 + b.size;
+            size_t best = b.size;
+            for (size_t i = 0; i < b.size; ++i) {
+                if (day_of(b.items[i]) != day) continue;
+                if (best == b.size ||
+                    time_of(b.items[i]) < time_of(b.items[best])) {
+                    best = i;
+                }
+            }
+            if (best != b.size) {
+                today = day;
+                top_bucket = &b;
+                top_index = best;
+                return;
+            }
+        }
+        locate_earliest();
+    }
+
+    /**
+     * @brief put t at the root of the max-heap h[0, n) and sift it down.
+     */
+    static void sift_down(time_type* h, size_t n, time_type t) {
+        size_t k = 0;
+        while (2 * k + 1 < n) {
+            size_t c = 2 * k + 1;
+            if (c + 1 < n && h[c] < h[c + 1]) ++c;
+            if (!(t < h[c])) break;
+            h[k] = h[c];
+            k = c;
+        }
+        h[k] = t;
+    }
+
+    /**
+     * @brief the day width for the current events: three times the mean
+     * gap between the earliest ones, ignoring gaps over twice the mean.
+     */
+    double estimate_width() const {
+        // a max-heap of the earliest times seen
+        time_type sample[sample_size];
+        size_t n = 0;
+        for (size_t j = 0; j < bucket_count; ++j) {
+            for (size_t i = 0; i < buckets[j].size; ++i) {
+                time_type t = time_of(buckets[j].items[i]);
+                if (n == sample_size) {
+                    if (t < sample[0]) sift_down(sample, n, t);
+                    continue;
+                }
+                size_t k = n++;
+                while (k > 0 && sample[(k - 1) / 2] < t) {
+                    sample[k] = sample[(k - 1) / 2];
+                    k = (k - 1) / 2;
+                }
+                sample[k] = t;
+            }
+        }
+        if (n < 2) return width;
+        // heap sort the sample, earliest first
+        for (size_t end = n; end-- > 1;) {
+            time_type t = sample[end];
+            sample[end] = sample[0];
+            sift_down(sample, end, t);
+        }
+        double span = static_cast<double>(sample[n - 1]) -
+                      static_cast<double>(sample[0]);
+        double mean = span / static_cast<double>(n - 1);
+        double kept = 0;
+        size_t gaps = 0;
+        for (size_t i = 0; i + 1 < n; ++i) {
+            double gap = static_cast<double>(sample[i + 1]) -
+                         static_cast<double>(sample[i]);
+            if (gap <= 2 * mean) {
+                kept += gap;
+                ++gaps;
+            }
+        }
+        double estimate = gaps ? 3 * kept / static_cast<double>(gaps) : 0;
+        return estimate > 0 && std::isfinite(estimate) ? estimate : width;
+    }
+
+    /**
+     * @brief refile every event into a calendar of count buckets with a
+     * day width fresh_width. The new calendar is complete before the old
+     * one is freed.
+     */
+    void resize(size_t count, double fresh_width) {
+        bucket* fresh = new bucket[count]();
+        size_t mask = count - 1;
+        try {
+            for (size_t j = 0; j < bucket_count; ++j) {
+                for (size_t i = 0; i < buckets[j].size; ++i) {
+                    long long day =
+                        day_of(time_of(buckets[j].items[i]), fresh_width);
+                    ++fresh[static_cast<size_t>(day) & mask].capacity;
+                }
+            }
+            for (size_t j = 0; j < count; ++j) {
+                size_t n = fresh[j].capacity;
+                fresh[j].capacity = 0;
+                if (n) {
+                    fresh[j].items = allocate(n);
+                    fresh[j].capacity = n;
+                }
+            }
+            for (size_t j = 0; j < bucket_count; ++j) {
+                for (size_t i = 0; i < buckets[j].size; ++i) {
+                    T& e = buckets[j].items[i];
+                    bucket& to = fresh[static_cast<size_t>(day_of(
+                                           time_of(e), fresh_width)) &
+                                       mask];
+                    new (to.items + to.size) T(std::move_if_noexcept(e));
+                    ++to.size;
+                }
+            }
+        } catch (...) {
+            free_buckets(fresh, count);
+            throw;
+        }
+        free_buckets(buckets, bucket_count);
+        buckets = fresh;
+        bucket_count = count;
+        width = fresh_width;
+        // the earliest event sets today under the new width
+        if (_size) locate_earliest();
+        effort = served = 0;
+        patience = 1;
+    }
+
+    /**
+     * @brief halve the calendar when it is about to fall under half full,
+     * and estimate the day width afresh when pops have been looking at
+     * many days or events each: the times have drifted away from the
+     * width, which was only set when the calendar last changed size. The
+     * effort spent since the last estimate pays for the new one. Some times
+     * defeat any width, such as clusters more than a year apart; when the
+     * estimate comes out about the same, the calendar is left as it is and
+     * the next estimate has to wait twice as long.
+     */
+    void recalibrate() {
+        if (bucket_count > 2 && _size - 1 < bucket_count / 2) {
+            resize(bucket_count / 2, estimate_width());
+        } else if (served >= 64 && effort > 16 * served &&
+                   effort / patience >= _size + bucket_count) {
+            double fresh_width = estimate_width();
+            if (fresh_width < width / 2 || fresh_width > width * 2) {
+                resize(bucket_count, fresh_width);
+            } else {
+                effort = served = 0;
+                patience *= 2;
+            }
+        }
+    }
+
+    /**
+     * @brief take out the event locate() found.
+     */
+    void remove_top() {
+        bucket& b = *top_bucket;
+        size_t last = b.size - 1;
+        if (top_index != last) b.items[top_index] = std::move(b.items[last]);
+        b.items[last].~T();
+        --b.size;
+        --_size;
+        ++served;
+        top_bucket = nullptr;
+    }
+
+    void copy_from(const calendar_queue& other) {
+        if (!other.bucket_count) return;
+        buckets = new bucket[other.bucket_count]();
+        bucket_count = other.bucket_count;
+        for (size_t j = 0; j < bucket_count; ++j) {
+            const bucket& from = other.buckets[j];
+            if (!from.size) continue;
+            bucket& to = buckets[j];
+            to.items = allocate(from.size);
+            to.capacity = from.size;
+            for (; to.size < from.size; ++to.size) {
+                new (to.items + to.size) T(from.items[to.size]);
+            }
+        }
+        width = other.width;
+        today = other.today;
+        _size = other._size;
+    }
+
+    void destroy_all() {
+        free_buckets(buckets, bucket_count);
+        buckets = nullptr;
+        bucket_count = 0;
+        top_bucket = nullptr;
+        _size = 0;
+    }
+
+   public:
+    /**
+     * @brief default constructor
+     */
+    explicit calendar_queue(const TimeOf& time = TimeOf())
+        : buckets(nullptr),
+          bucket_count(0),
+          width(1),
+          today(0),
+          top_bucket(nullptr),
+          top_index(0),
+          effort(0),
+          served(0),
+          patience(1),
+          _size(0),
+          time_of(time) {
+    }
+
+    /**
+     * @brief copy constructor
+     */
+    calendar_queue(const calendar_queue& other)
+        : buckets(nullptr),
+          bucket_count(0),
+          width(1),
+          today(0),
+          top_bucket(nullptr),
+          top_index(0),
+          effort(0),
+          served(0),
+          patience(1),
+          _size(0),
+          time_of(other.time_of) {
+        try {
+            copy_from(other);
+        } catch (...) {
+            destroy_all();
+            throw;
+        }
+    }
+
+    /**
+     * @brief deconstructor
+     */
+    ~calendar_queue() {
+        destroy_all();
+    }
+
+    /**
+     * @brief Assignment operator
+     */
+    calendar_queue& operator=(const calendar_queue& other) {
+        if (this == &other) return *this;
+        calendar_queue copy(other);
+        swap(copy);
+        return *this;
+    }
+
+    void swap(calendar_queue& other) {
+        std::swap(buckets, other.buckets);
+        std::swap(bucket_count, other.bucket_count);
+        std::swap(width, other.width);
+        std::swap(today, other.today);
+        std::swap(top_bucket, other.top_bucket);
+        std::swap(top_index, other.top_index);
+        std::swap(effort, other.effort);
+        std::swap(served, other.served);
+        std::swap(patience, other.patience);
+        std::swap(_size, other._size);
+        std::swap(time_of, other.time_of);
+    }
+
+    /**
+     * @brief the event with the earliest time.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& top() const {
+        if (empty()) throw container_is_empty();
+        locate();
+        return top_bucket->items[top_index];
+    }
+
+    /**
+     * @brief push new element to the queue.
+     */
+    void push(const T& e) {
+        emplace(e);
+    }
+
+    /**
+     * @brief push an element, moving from e.
+     */
+    void push(T&& e) {
+        emplace(std::move(e));
+    }
+
+    /**
+     * @brief push an element constructed in place from args.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        T value(std::forward<Args>(args)...);
+        if (_size + 1 > 2 * bucket_count) {
+            resize(bucket_count ? 2 * bucket_count : 2, estimate_width());
+        }
+        long long day = day_of(value);
+        bucket& b = bucket_of(day);
+        reserve(b, b.size + 1);
+        new (b.items + b.size) T(std::move(value));
+        ++b.size;
+        ++_size;
+        if (_size == 1 || day < today) {
+            today = day;
+            top_bucket = nullptr;
+        }
+        if (top_bucket && time_of(b.items[b.size - 1]) <
+                              time_of(top_bucket->items[top_index])) {
+            top_bucket = &b;
+            top_index = b.size - 1;
+        }
+    }
+
+    /**
+     * @brief delete the earliest event.
+     * @throws container_is_empty if empty() returns true
+     */
+    void pop() {
+        if (empty()) throw container_is_empty();
+        recalibrate();
+        locate();
+        remove_top();
+    }
+
+    /**
+     * @brief remove the earliest event and return it, moved out.
+     * @throws container_is_empty if empty() returns true
+     */
+    T pop_value() {
+        if (empty()) throw container_is_empty();
+        recalibrate();
+        locate();
+        T value(std::move_if_noexcept(top_bucket->items[top_index]));
+        remove_top();
+        return value;
+    }
+
+    /**
+     * @brief the current day width, for tuning.
+     */
+    double day_width() const {
+        return width;
+    }
+
+    /**
+     * @brief return the number of events.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @brief check if the queue is empty.
+     */
+    bool empty() const {
+        return _size == 0;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,747 @@
+#ifndef SJTU_DARY_HEAP_HPP
+#define SJTU_DARY_HEAP_HPP
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+#include "exceptions.hpp"
+#include "priority_queue.hpp"
+
+namespace sjtu {
+/**
+ * @brief engine tag for priority_queue: an implicit D-ary heap stored in one
+ * contiguous, cache-line aligned array.
+ * push and pop touch one array slot per level instead of chasing a pointer
+ * per node, and the D children of a node share a cache line as long as
+ * D * sizeof(T) <= 64. merge falls back to heapifying both arrays, O(n + m).
+ * Pick D = 4 for small T; D = 2 or 8 trade pop cost against push cost.
+ */
+template <size_t D>
+struct dary_heap {
+    static_assert(D >= 2, "a d-ary heap needs at least two children per node");
+};
+
+template <typename T, class Compare>
+class top_k;
+
+template <typename T, class Compare, size_t D>
+class priority_queue<T, Compare, dary_heap<D>> {
+    // top_k compares through cmp and copies into its reserved storage
+    template <typename, class>
+    friend class top_k;
+
+   private:
+    static constexpr size_t alignment = alignof(T) > 64 ? alignof(T) : 64;
+    // log_D(SIZE_MAX) < 64, so a root-to-leaf path always fits
+    static const size_t max_depth = 64;
+
+    // slots[0, D - 1) are never constructed; they shift the heap so that
+    // the children of heap node i, heap[D * i + 1, D * i + D], begin at
+    // slots[D * (i + 1)], a multiple of D from an aligned base
+    T* slots;
+    size_t _size;
+    size_t capacity;
+    // takes no space when Compare is empty
+    [[no_unique_address]] Compare cmp;
+
+    static T* allocate(size_t n) {
+        return static_cast<T*>(operator new((n + D - 1) * sizeof(T),
+                                            std::align_val_t(alignment)));
+    }
+
+    static void deallocate(T* p) {
+        if (p) operator delete(p, std::align_val_t(alignment));
+    }
+
+    T* heap() const {
+        return slots + (D - 1);
+    }
+
+    void destroy_all() {
+        for (size_t i = 0; i < _size; ++i) {
+            heap()[i].~T();
+        }
+        deallocate(slots);
+        slots = nullptr;
+        _size = capacity = 0;
+    }
+
+    /**
+     * @brief copy-construct all elements of other, keeping its layout, into
+     * storage for at least room elements.
+     */
+    void copy_from(const priority_queue& other, size_t room = 0) {
+        size_t n = other._size > room ? other._size : room;
+        if (n == 0) return;
+        T* fresh = allocate(n);
+        T* target = fresh + (D - 1);
+        size_t built = 0;
+        try {
+            for (; built < other._size; ++built) {
+                new (target + built) T(other.heap()[built]);
+            }
+        } catch (...) {
+            for (size_t i = 0; i < built; ++i) target[i].~T();
+            deallocate(fresh);
+            throw;
+        }
+        slots = fresh;
+        _size = other._size;
+        capacity = n;
+    }
+
+    /**
+     * @brief Floyd's bottom-up heap construction over h[0, n).
+     */
+    void heapify(T* h, size_t n) const {
+        if (n < 2) return;
+        for (size_t start = (n - 2) / D + 1; start-- > 0;) {
+            size_t i = start;
+            while (true) {
+                size_t first = D * i + 1;
+                if (first >= n) break;
+                size_t end = first + D < n ? first + D : n;
+                size_t best = first;
+                for (size_t c = first + 1; c < end; ++c) {
+                    if (cmp(h[best], h[c])) best = c;
+                }
+                if (!cmp(h[i], h[best])) break;
+                std::swap(h[i], h[best]);
+                i = best;
+            }
+        }
+    }
+
+    void swap_storage(priority_queue& other) {
+        std::swap(slots, other.slots);
+        std::swap(_size, other._size);
+        std::swap(capacity, other.capacity);
+    }
+
+    /**
+     * @brief copy [first, last) to the back of the array, unordered.
+     * Storage is sized once when the distance is known up front. If
+     * anything throws, the appended elements are destroyed again.
+     */
+    template <class InputIt>
+    void append(InputIt first, InputIt last) {
+        if constexpr (requires { static_cast<size_t>(last - first); }) {
+            reserve(_size + static_cast<size_t>(last - first));
+        } else if constexpr (std::forward_iterator<InputIt>) {
+            reserve(_size +
+                    static_cast<size_t>(std::ranges::distance(first, last)));
+        }
+        size_t n = _size;
+        try {
+            for (; first != last; ++first) {
+                reserve(_size + 1);
+                new (heap() + _size) T(*first);
+                ++_size;
+            }
+        } catch (...) {
+            for (size_t i = n; i < _size; ++i) heap()[i].~T();
+            _size = n;
+            throw;
+        }
+    }
+
+    /**
+     * @brief copy [first, last) into this empty queue and heapify it, in
+     * O(n).
+     */
+    template <class InputIt>
+    void fill(InputIt first, InputIt last) {
+        append(first, last);
+        try {
+            heapify(heap(), _size);
+        } catch (...) {
+            throw runtime_error();
+        }
+    }
+
+    /**
+     * @brief a fresh array of a[0, na) followed by b[0, nb), copied and
+     * heapified, in O(na + nb). Nothing is touched if anything throws.
+     */
+    T* rebuilt(const T* a, size_t na, const T* b, size_t nb) const {
+        size_t total = na + nb;
+        T* fresh = allocate(total);
+        T* target = fresh + (D - 1);
+        size_t built = 0;
+        try {
+            for (; built < na; ++built) {
+                new (target + built) T(a[built]);
+            }
+            for (; built < total; ++built) {
+                new (target + built) T(b[built - na]);
+            }
+        } catch (...) {
+            for (size_t i = 0; i < built; ++i) target[i].~T();
+            deallocate(fresh);
+            throw;
+        }
+        try {
+            heapify(target, total);
+        } catch (...) {
+            for (size_t i = 0; i < total; ++i) target[i].~T();
+            deallocate(fresh);
+            throw runtime_error();
+        }
+        return fresh;
+    }
+
+    /**
+     * @brief the slot h[at] rises to above the heap h[0, at), decided with
+     * comparisons only.
+     */
+    size_t plan_up(size_t at) const {
+        T* h = heap();
+        size_t hole = at;
+        while (hole > 0) {
+            size_t parent = (hole - 1) / D;
+            if (!cmp(h[parent], h[at])) break;
+            hole = parent;
+        }
+        return hole;
+    }
+
+    /**
+     * @brief move h[at] up to its planned hole, shifting the ancestors in
+     * between down one level.
+     */
+    void lift(size_t at, size_t hole) {
+        if (hole == at) return;
+        T* h = heap();
+        T value(std::move(h[at]));
+        for (size_t i = at; i != hole;) {
+            size_t parent = (i - 1) / D;
+            h[i] = std::move(h[parent]);
+            i = parent;
+        }
+        h[hole] = std::move(value);
+    }
+
+    /**
+     * @brief undo lift(at, hole).
+     */
+    void unlift(size_t at, size_t hole) {
+        if (hole == at) return;
+        T* h = heap();
+        size_t chain[max_depth];
+        size_t length = 0;
+        for (size_t i = at; i != hole; i = (i - 1) / D) chain[length++] = i;
+        T value(std::move(h[hole]));
+        size_t i = hole;
+        while (length > 0) {
+            size_t below = chain[--length];
+            h[i] = std::move(h[below]);
+            i = below;
+        }
+        h[at] = std::move(value);
+    }
+
+    /**
+     * @brief the slots e sifts through when it replaces the top of
+     * h[0, n), decided with comparisons only.
+     * @return the path length
+     */
+    size_t plan_down(size_t n, const T& e, size_t* path) const {
+        T* h = heap();
+        size_t depth = 0;
+        try {
+            for (size_t i = 0;;) {
+                size_t first = D * i + 1;
+                if (first >= n) break;
+                size_t end = first + D < n ? first + D : n;
+                size_t best = first;
+                for (size_t c = first + 1; c < end; ++c) {
+                    if (cmp(h[best], h[c])) best = c;
+                }
+                if (!cmp(e, h[best])) break;
+                path[depth++] = best;
+                i = best;
+            }
+        } catch (...) {
+            throw runtime_error();
+        }
+        return depth;
+    }
+
+    /**
+     * @brief the slots h[n - 1] sifts through when it replaces the top of
+     * h[0, n - 1).
+     */
+    size_t plan_pop(size_t n, size_t* path) const {
+        return plan_down(n - 1, heap()[n - 1], path);
+    }
+
+    /**
+     * @brief shift a planned path up by one level, overwriting the top.
+     * @return the hole left at the end of the path
+     */
+    size_t shift_up(const size_t* path, size_t depth) {
+        T* h = heap();
+        size_t hole = 0;
+        for (size_t k = 0; k < depth; ++k) {
+            h[hole] = std::move(h[path[k]]);
+            hole = path[k];
+        }
+        return hole;
+    }
+
+    /**
+     * @brief move the elements along a planned path, overwriting the top.
+     */
+    void remove_top(const size_t* path, size_t depth) {
+        T* h = heap();
+        size_t last = _size - 1;
+        size_t hole = shift_up(path, depth);
+        if (hole != last) h[hole] = std::move(h[last]);
+        h[last].~T();
+        --_size;
+    }
+
+    /**
+     * @brief put h[n, size()) back on top of the heap h[0, n), without
+     * comparisons. It must hold elements no less than the heap's, least
+     * first: each goes to the root and pushes its ancestors' path down.
+     */
+    void restore_tail(size_t n) {
+        T* h = heap();
+        for (; n < _size; ++n) {
+            T value(std::move(h[n]));
+            size_t i = n;
+            while (i > 0) {
+                size_t parent = (i - 1) / D;
+                h[i] = std::move(h[parent]);
+                i = parent;
+            }
+            h[0] = std::move(value);
+        }
+    }
+
+    /**
+     * @brief a partial heap sort in place: the best count elements end up
+     * at the back of the array, best last. If Compare throws, the sorted
+     * part is put back on top and the heap holds what it held.
+     */
+    void sort_tail(size_t count) {
+        T* h = heap();
+        size_t n = _size;
+        try {
+            for (; n > _size - count; --n) {
+                size_t path[max_depth];
+                size_t depth = plan_pop(n, path);
+                T best(std::move(h[0]));
+                size_t hole = shift_up(path, depth);
+                if (hole != n - 1) h[hole] = std::move(h[n - 1]);
+                h[n - 1] = std::move(best);
+            }
+        } catch (...) {
+            restore_tail(n);
+            throw;
+        }
+    }
+
+   public:
+    /**
+     * @brief default constructor
+     */
+    priority_queue() : slots(nullptr), _size(0), capacity(0), cmp() {
+    }
+
+    /**
+     * @brief an empty queue ordered by a copy of compare, which may carry
+     * state.
+     */
+    explicit priority_queue(const Compare& compare)
+        : slots(nullptr), _size(0), capacity(0), cmp(compare) {
+    }
+
+    /**
+     * @brief a queue of the elements of [first, last), built in O(n) by
+     * Floyd's heapify instead of by n pushes.
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    priority_queue(InputIt first, InputIt last,
+                   const Compare& compare = Compare())
+        : slots(nullptr), _size(0), capacity(0), cmp(compare) {
+        try {
+            fill(first, last);
+        } catch (...) {
+            destroy_all();
+            throw;
+        }
+    }
+
+    /**
+     * @brief a queue of the elements of a container such as sjtu::vector.
+     */
+    template <class Container,
+              class = decltype(std::declval<const Container&>().begin())>
+    explicit priority_queue(const Container& elements,
+                            const Compare& compare = Compare())
+        : priority_queue(elements.begin(), elements.end(), compare) {
+    }
+
+    /**
+     * @brief copy constructor
+     * @param other the priority_queue to be copied
+     */
+    priority_queue(const priority_queue& other)
+        : slots(nullptr), _size(0), capacity(0), cmp(other.cmp) {
+        copy_from(other);
+    }
+
+    /**
+     * @brief deconstructor
+     */
+    ~priority_queue() {
+        destroy_all();
+    }
+
+    /**
+     * @brief Assignment operator
+     * @param other the priority_queue to be assigned from
+     * @return a reference to this priority_queue after assignment
+     */
+    priority_queue& operator=(const priority_queue& other) {
+        if (this == &other) return *this;
+        destroy_all();
+        copy_from(other);
+        cmp = other.cmp;
+        return *this;
+    }
+
+    /**
+     * @brief replace the contents with the elements of [first, last) in
+     * O(n). If anything throws, the queue keeps its old contents.
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void assign(InputIt first, InputIt last) {
+        priority_queue staged(cmp);
+        staged.fill(first, last);
+        swap_storage(staged);
+    }
+
+    /**
+     * @brief replace the contents with the elements of a container.
+     */
+    template <class Container,
+              class = decltype(std::declval<const Container&>().begin())>
+    void assign(const Container& elements) {
+        assign(elements.begin(), elements.end());
+    }
+
+    /**
+     * @brief make room for n elements, so that pushes up to that size do
+     * not allocate. Elements are copied, or moved when that cannot throw;
+     * the old storage is kept if anything throws.
+     */
+    void reserve(size_t n) {
+        if (n <= capacity) return;
+        size_t grown = capacity < 8 ? 8 : capacity * 2;
+        if (grown < n) grown = n;
+        T* fresh = allocate(grown);
+        T* target = fresh + (D - 1);
+        size_t built = 0;
+        try {
+            for (; built < _size; ++built) {
+                new (target + built) T(std::move_if_noexcept(heap()[built]));
+            }
+        } catch (...) {
+            for (size_t i = 0; i < built; ++i) target[i].~T();
+            deallocate(fresh);
+            throw;
+        }
+        for (size_t i = 0; i < _size; ++i) heap()[i].~T();
+        deallocate(slots);
+        slots = fresh;
+        capacity = grown;
+    }
+
+    /**
+     * @brief remove every element, keeping the storage.
+     */
+    void clear() {
+        for (size_t i = 0; i < _size; ++i) heap()[i].~T();
+        _size = 0;
+    }
+
+    /**
+     * @brief get the top element of the priority queue.
+     * @return a reference of the top element.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& top() const {
+        if (empty()) throw container_is_empty();
+        return heap()[0];
+    }
+
+    /**
+     * @brief push new element to the priority queue.
+     * The new element's final slot is found with comparisons only; elements
+     * are moved once it is known, so a throwing Compare changes nothing.
+     * @param e the element to be pushed
+     */
+    void push(const T& e) {
+        emplace(e);
+    }
+
+    /**
+     * @brief push an element, moving from e.
+     */
+    void push(T&& e) {
+        emplace(std::move(e));
+    }
+
+    /**
+     * @brief push an element constructed in place from args.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        if (_size == capacity) {
+            // args may refer into the array, so build before it moves
+            T value(std::forward<Args>(args)...);
+            reserve(_size + 1);
+            new (heap() + _size) T(std::move(value));
+        } else {
+            new (heap() + _size) T(std::forward<Args>(args)...);
+        }
+        size_t hole;
+        try {
+            hole = plan_up(_size);
+        } catch (...) {
+            heap()[_size].~T();
+            throw runtime_error();
+        }
+        lift(_size, hole);
+        ++_size;
+    }
+
+    /**
+     * @brief push the elements of [first, last) at once. A batch at least
+     * as large as the queue is heapified together with it in O(n + m);
+     * a smaller one is appended and sifted up. Either way, if anything
+     * throws, the queue is left as it was.
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void push_range(InputIt first, InputIt last) {
+        size_t n = _size;
+        append(first, last);
+        size_t m = _size - n;
+        if (m == 0) return;
+        if (n == 0) {
+            try {
+                heapify(heap(), _size);
+            } catch (...) {
+                for (size_t i = 0; i < _size; ++i) heap()[i].~T();
+                _size = 0;
+                throw runtime_error();
+            }
+            return;
+        }
+        if (m >= n) {
+            T* fresh;
+            try {
+                fresh = rebuilt(heap(), _size, nullptr, 0);
+            } catch (...) {
+                for (size_t i = n; i < _size; ++i) heap()[i].~T();
+                _size = n;
+                throw;
+            }
+            size_t total = _size;
+            destroy_all();
+            slots = fresh;
+            _size = capacity = total;
+            return;
+        }
+        // where each new element came to rest, to undo them in reverse
+        size_t* holes = nullptr;
+        size_t j = 0;
+        bool sifting = false;
+        try {
+            holes = static_cast<size_t*>(operator new(m * sizeof(size_t)));
+            sifting = true;
+            for (; j < m; ++j) {
+                holes[j] = plan_up(n + j);
+                lift(n + j, holes[j]);
+            }
+        } catch (...) {
+            while (j-- > 0) unlift(n + j, holes[j]);
+            operator delete(holes);
+            for (size_t i = n; i < _size; ++i) heap()[i].~T();
+            _size = n;
+            if (sifting) throw runtime_error();
+            throw;
+        }
+        operator delete(holes);
+    }
+
+    /**
+     * @brief push the elements of a container such as sjtu::vector.
+     */
+    template <class Container,
+              class = decltype(std::declval<const Container&>().begin())>
+    void push_range(const Container& elements) {
+        push_range(elements.begin(), elements.end());
+    }
+
+    /**
+     * @brief delete the top element from the priority queue.
+     * Like push, the sift-down path is decided before anything moves.
+     * @throws container_is_empty if empty() returns true
+     */
+    void pop() {
+        if (empty()) throw container_is_empty();
+        size_t path[max_depth];
+        size_t depth = plan_pop(_size, path);
+        remove_top(path, depth);
+    }
+
+    /**
+     * @brief replace the top element with e in one sift down, cheaper than
+     * pop() followed by push(e). Like pop, the path is decided before
+     * anything moves, so a throwing Compare changes nothing.
+     * @throws container_is_empty if empty() returns true
+     */
+    template <class U>
+    void replace_top(U&& e) {
+        if (empty()) throw container_is_empty();
+        size_t path[max_depth];
+        size_t depth = plan_down(_size, e, path);
+        heap()[shift_up(path, depth)] = std::forward<U>(e);
+    }
+
+    /**
+     * @brief remove the top element and return it, moved out rather than
+     * copied (unless T can only be moved by a throwing constructor).
+     * @throws container_is_empty if empty() returns true
+     */
+    T pop_value() {
+        if (empty()) throw container_is_empty();
+        size_t path[max_depth];
+        size_t depth = plan_pop(_size, path);
+        T value(std::move_if_noexcept(heap()[0]));
+        remove_top(path, depth);
+        return value;
+    }
+
+    /**
+     * @brief move the best min(k, size()) elements to out, best first, and
+     * remove them. A partial heap sort in place, with no per-pop
+     * bookkeeping. If Compare throws, the queue keeps all its elements. If
+     * writing to out throws, the elements not yet written stay in the queue.
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt pop_k(size_t k, OutputIt out) {
+        size_t count = k < _size ? k : _size;
+        sort_tail(count);
+        T* h = heap();
+        try {
+            for (; count > 0; --count) {
+                *out = std::move(h[_size - 1]);
+                ++out;
+                h[_size - 1].~T();
+                --_size;
+            }
+        } catch (...) {
+            restore_tail(_size - count);
+            throw;
+        }
+        return out;
+    }
+
+    /**
+     * @brief move every element to out, best first, leaving the queue
+     * empty; a heap sort in place, O(n log n).
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt drain_sorted(OutputIt out) {
+        return pop_k(_size, out);
+    }
+
+    /**
+     * @brief move every element to out, worst first, leaving the queue
+     * empty. The heap sort of drain_sorted() is reversed in place first:
+     * sorted best first, the array is a heap at every length, so if
+     * writing to out throws, the elements not yet written stay in the
+     * queue.
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt drain_reversed(OutputIt out) {
+        sort_tail(_size);
+        T* h = heap();
+        for (size_t i = 0, j = _size; i + 1 < j; ++i, --j) {
+            std::swap(h[i], h[j - 1]);
+        }
+        while (_size > 0) {
+            *out = std::move(h[_size - 1]);
+            ++out;
+            h[--_size].~T();
+        }
+        return out;
+    }
+
+    /**
+     * @brief return the number of elements in the priority queue.
+     * @return the number of elements.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @brief check if the container is empty.
+     * @return true if it is empty, false otherwise.
+     */
+    bool empty() const {
+        return _size == 0;
+    }
+
+    /**
+     * @brief a copy of the comparator that orders the queue.
+     */
+    Compare value_comp() const {
+        return cmp;
+    }
+
+    /**
+     * @brief merge another priority_queue into this one.
+     * The other priority_queue will be cleared after merging.
+     * Both queues must order elements the same way; this one's comparator
+     * is used.
+     * An array heap cannot meld, so both arrays are copied side by side and
+     * heapified in O(n + m); if Compare throws, both queues keep their
+     * original contents. Merging into an empty queue just takes the array.
+     * @param other the priority_queue to be merged.
+     */
+    void merge(priority_queue& other) {
+        if (this == &other || other._size == 0) return;
+        if (_size == 0) {
+            swap_storage(other);
+            return;
+        }
+        size_t total = _size + other._size;
+        T* fresh = rebuilt(heap(), _size, other.heap(), other._size);
+        destroy_all();
+        other.destroy_all();
+        slots = fresh;
+        _size = capacity = total;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,506 @@
+#ifndef SJTU_EXTERNAL_QUEUE_HPP
+#define SJTU_EXTERNAL_QUEUE_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "exceptions.hpp"
+
+namespace sjtu {
+/**
+ * @brief a priority queue that keeps within a memory budget by spilling to
+ * temporary files, for queues larger than memory. top() is the greatest
+ * element, as in priority_queue.
+ *
+ * New elements go into a binary heap that takes half the budget. When it
+ * is full, it is sorted and written out, greatest first, as a run in a
+ * file of its own. top() is the greater of the heap's top and the first
+ * unread element of every run, so runs are merged lazily as elements are
+ * popped. Each run is read through a buffer of a block, 1/32 of the budget,
+ * and every write is a whole block too, so disk traffic is large and
+ * sequential. Runs carry a level, spills being level 0; eight runs of one
+ * level are merged into a run of the next level, so an element is written
+ * about log8(size / heap capacity) + 1 times and the buffers of the
+ * runs kept open stay within the rest of the budget. Fifteen runs are
+ * open at most; past that, the runs below the top level are merged into
+ * one more run of the top level.
+ *
+ * Elements are stored as their bytes, so T must be trivially copyable.
+ * Files come from std::tmpfile() and go away when closed, or when the
+ * program ends. bytes_written() and bytes_read() report the disk traffic.
+ *
+ * Compare must not throw.
+ *
+ * **Exception Safety**: if a file cannot be created, written or read,
+ * runtime_error is thrown and the queue holds the same elements as before:
+ * a failed spill leaves the heap in memory, a failed merge leaves the runs
+ * it read from where they were, and a failed read leaves the run unread.
+ */
+template <typename T, class Compare = std::less<T>>
+class external_priority_queue {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "external_priority_queue stores elements as bytes");
+
+   private:
+    // runs of one level merged into one of the next
+    static const size_t fanout = 8;
+    // read buffers open at most, with a write buffer making sixteen blocks
+    static const size_t max_runs = 15;
+
+    // a run's file position when a failed read or seek has lost it
+    static const size_t position_lost = size_t(-1);
+
+    struct run {
+        std::FILE* file;
+        // elements in the file, and the index of the first unread one
+        size_t count;
+        size_t next;
+        // the element the file is positioned at; reads go forward from
+        // there, so the file is only sought after a rollback or a failure
+        size_t at;
+        // elements [begin, end) of the file are in buffer
+        T* buffer;
+        size_t begin;
+        size_t end;
+        size_t level;
+    };
+
+    T* heap;
+    size_t heap_size;
+    size_t heap_capacity;
+    // elements per buffer and per write
+    size_t block;
+    mutable run runs[max_runs + 1];
+    size_t run_total;
+    T* write_buffer;
+    // the run whose head is top(), max_runs if it is the heap's top
+    mutable size_t best;
+    mutable bool best_known;
+    size_t _size;
+    size_t budget;
+    size_t written;
+    mutable size_t read;
+    [[no_unique_address]] Compare cmp;
+
+    static T* allocate(size_t n) {
+        return static_cast<T*>(
+            operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    static void deallocate(T* p) {
+        if (p) operator delete(p, std::align_val_t(alignof(T)));
+    }
+
+    void sift_up(size_t i) {
+        T moved = heap[i];
+        while (i > 0 && cmp(heap[(i - 1) / 2], moved)) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = moved;
+    }
+
+    void sift_down(size_t i, size_t n) {
+        T moved = heap[i];
+        while (2 * i + 1 < n) {
+            size_t child = 2 * i + 1;
+            if (child + 1 < n && cmp(heap[child], heap[child + 1])) ++child;
+            if (!cmp(moved, heap[child])) break;
+            heap[i] = heap[child];
+            i = child;
+        }
+        heap[i] = moved;
+    }
+
+    /**
+     * @brief position the file of run r at element i. Offsets go to fseek
+     * a gigabyte at most at a time, as a long may be 32 bits.
+     */
+    static void seek(run& r, size_t i) {
+        if (r.at == i) return;
+        size_t at = r.at;
+        r.at = position_lost;
+        if (at == position_lost) {
+            if (std::fseek(r.file, 0, SEEK_SET) != 0) throw runtime_error();
+            at = 0;
+        }
+        const size_t step = sizeof(T) < (size_t(1) << 30)
+                                ? (size_t(1) << 30) / sizeof(T)
+                                : 1;
+        while (at != i) {
+            size_t d = at < i ? i - at : at - i;
+            if (d > step) d = step;
+            long bytes = static_cast<long>(d * sizeof(T));
+            if (std::fseek(r.file, at < i ? bytes : -bytes, SEEK_CUR) != 0) {
+                throw runtime_error();
+            }
+            at = at < i ? at + d : at - d;
+        }
+        r.at = i;
+    }
+
+    /**
+     * @brief make sure the first unread element of run r is in its buffer,
+     * reading the block that starts there if not.
+     */
+    void load(run& r) const {
+        if (r.next >= r.begin && r.next < r.end) return;
+        if (!r.buffer) r.buffer = allocate(block);
+        size_t n = r.count - r.next < block ? r.count - r.next : block;
+        // the buffer is invalid until the read has succeeded
+        r.begin = r.end = r.next;
+        seek(r, r.next);
+        if (std::fread(r.buffer, sizeof(T), n, r.file) != n) {
+            r.at = position_lost;
+            throw runtime_error();
+        }
+        r.at = r.end = r.next + n;
+        read += n * sizeof(T);
+    }
+
+    const T& head(const run& r) const {
+        return r.buffer[r.next - r.begin];
+    }
+
+    static void write(std::FILE* file, const T* data, size_t n) {
+        if (std::fwrite(data, sizeof(T), n, file) != n) throw runtime_error();
+    }
+
+    static std::FILE* open_file() {
+        std::FILE* file = std::tmpfile();
+        if (!file) throw runtime_error();
+        return file;
+    }
+
+    /**
+     * @brief add a run of count elements in file; its buffer is read when
+     * first needed. The caller still owns file if this throws.
+     * @throws runtime_error if no more runs fit
+     */
+    void add_run(std::FILE* file, size_t count, size_t level) {
+        if (run_total == max_runs + 1) throw runtime_error();
+        runs[run_total++] =
+            run{file, count, 0, position_lost, nullptr, 0, 0, level};
+        best_known = false;
+    }
+
+    void close_run(size_t r) {
+        std::fclose(runs[r].file);
+        deallocate(runs[r].buffer);
+        runs[r] = runs[--run_total];
+        best_known = false;
+    }
+
+    /**
+     * @brief find where top() is: the greatest of the heap's top and the
+     * heads of the runs.
+     */
+    void locate() const {
+        if (best_known) return;
+        size_t found = max_runs;
+        const T* greatest = heap_size ? heap : nullptr;
+        for (size_t r = 0; r < run_total; ++r) {
+            load(runs[r]);
+            if (!greatest || cmp(*greatest, head(runs[r]))) {
+                greatest = &head(runs[r]);
+                found = r;
+            }
+        }
+        best = found;
+        best_known = true;
+    }
+
+    /**
+     * @brief write the heap out as a run and empty it. The heap is sorted
+     * in place first; if writing fails, the sorted array is turned into a
+     * heap again by reversing it, without a comparison.
+     */
+    void spill() {
+        size_t n = heap_size;
+        for (size_t end = n; end-- > 1;) {
+            std::swap(heap[0], heap[end]);
+            sift_down(0, end);
+        }
+        std::FILE* file = nullptr;
+        try {
+            file = open_file();
+            // greatest first: walk the ascending array from the back
+            for (size_t done = 0; done < n;) {
+                size_t m = n - done < block ? n - done : block;
+                for (size_t i = 0; i < m; ++i) {
+                    write_buffer[i] = heap[n - 1 - done - i];
+                }
+                write(file, write_buffer, m);
+                done += m;
+            }
+            if (std::fflush(file) != 0) throw runtime_error();
+            add_run(file, n, 0);
+        } catch (...) {
+            if (file) std::fclose(file);
+            for (size_t i = 0, j = n; i + 1 < j; ++i, --j) {
+                std::swap(heap[i], heap[j - 1]);
+            }
+            throw;
+        }
+        written += n * sizeof(T);
+        heap_size = 0;
+    }
+
+    /**
+     * @brief merge the runs of levels low to high into one run of the
+     * given level. Every source is read from where it was; if anything
+     * fails, each is put back there and the new file is dropped.
+     */
+    void merge_runs(size_t low, size_t high, size_t level) {
+        size_t sources[max_runs + 1];
+        size_t saved[max_runs + 1];
+        size_t k = 0, total = 0;
+        for (size_t r = 0; r < run_total; ++r) {
+            if (runs[r].level < low || runs[r].level > high) continue;
+            sources[k] = r;
+            saved[k++] = runs[r].next;
+            total += runs[r].count - runs[r].next;
+        }
+        std::FILE* file = nullptr;
+        try {
+            file = open_file();
+            size_t n = 0;
+            for (size_t done = 0; done < total; ++done) {
+                run* greatest = nullptr;
+                for (size_t i = 0; i < k; ++i) {
+                    run& r = runs[sources[i]];
+                    if (r.next == r.count) continue;
+                    load(r);
+                    if (!greatest || cmp(head(*greatest), head(r))) {
+                        greatest = &r;
+                    }
+                }
+                write_buffer[n++] = head(*greatest);
+                ++greatest->next;
+                if (n == block || done + 1 == total) {
+                    write(file, write_buffer, n);
+                    n = 0;
+                }
+            }
+            if (std::fflush(file) != 0) throw runtime_error();
+            add_run(file, total, level);
+        } catch (...) {
+            if (file) std::fclose(file);
+            for (size_t i = 0; i < k; ++i) runs[sources[i]].next = saved[i];
+            best_known = false;
+            throw;
+        }
+        written += total * sizeof(T);
+        // close the sources from the back, as closing moves the last run;
+        // the new run is last and no source
+        for (size_t i = k; i-- > 0;) close_run(sources[i]);
+    }
+
+    /**
+     * @brief merge the levels that have filled up, lowest first. If too
+     * many runs are open still, the runs below the top level are merged
+     * into one more run of the top level, which may fill it up in turn.
+     */
+    void compact() {
+        while (true) {
+            size_t top_level = 0;
+            for (size_t r = 0; r < run_total; ++r) {
+                if (runs[r].level > top_level) top_level = runs[r].level;
+            }
+            bool merged = false;
+            for (size_t level = 0; level <= top_level && !merged; ++level) {
+                size_t count = 0;
+                for (size_t r = 0; r < run_total; ++r) {
+                    if (runs[r].level == level) ++count;
+                }
+                if (count >= fanout) {
+                    merge_runs(level, level, level + 1);
+                    merged = true;
+                }
+            }
+            if (!merged && run_total >= max_runs) {
+                merge_runs(0, top_level - 1, top_level);
+                merged = true;
+            }
+            if (!merged) return;
+        }
+    }
+
+    /**
+     * @brief take out the element locate() found.
+     */
+    void remove_top() {
+        if (best == max_runs) {
+            heap[0] = heap[--heap_size];
+            if (heap_size > 1) sift_down(0, heap_size);
+        } else {
+            run& r = runs[best];
+            if (++r.next == r.count) close_run(best);
+        }
+        --_size;
+        best_known = false;
+    }
+
+   public:
+    /**
+     * @brief an empty queue that keeps about memory_budget bytes of
+     * elements in memory, 64 MiB by default.
+     */
+    explicit external_priority_queue(size_t memory_budget = size_t(64) << 20,
+                                     const Compare& compare = Compare())
+        : heap(nullptr),
+          heap_size(0),
+          runs(),
+          run_total(0),
+          write_buffer(nullptr),
+          best(max_runs),
+          best_known(false),
+          _size(0),
+          budget(memory_budget),
+          written(0),
+          read(0),
+          cmp(compare) {
+        size_t capacity = memory_budget / sizeof(T);
+        if (capacity < 64) capacity = 64;
+        heap_capacity = capacity / 2;
+        block = capacity / 32;
+        heap = allocate(heap_capacity);
+        try {
+            write_buffer = allocate(block);
+        } catch (...) {
+            deallocate(heap);
+            throw;
+        }
+    }
+
+    // files are not shared, so the queue is not copied
+    external_priority_queue(const external_priority_queue&) = delete;
+    external_priority_queue& operator=(const external_priority_queue&) =
+        delete;
+
+    /**
+     * @brief deconstructor; closes and so removes the files.
+     */
+    ~external_priority_queue() {
+        while (run_total) close_run(run_total - 1);
+        deallocate(heap);
+        deallocate(write_buffer);
+    }
+
+    /**
+     * @brief get the top element. It may have to be read from disk.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& top() const {
+        if (empty()) throw container_is_empty();
+        locate();
+        return best == max_runs ? heap[0] : head(runs[best]);
+    }
+
+    /**
+     * @brief push new element to the queue, spilling the heap to disk if
+     * it is full.
+     */
+    void push(const T& e) {
+        emplace(e);
+    }
+
+    /**
+     * @brief construct an element from args in the queue.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        T value(std::forward<Args>(args)...);
+        if (heap_size == heap_capacity) {
+            // a compaction that failed after the last spill left its runs
+            // open; make room first, so a failure adds no run
+            if (run_total >= max_runs) compact();
+            spill();
+            compact();
+        }
+        heap[heap_size] = value;
+        sift_up(heap_size++);
+        ++_size;
+        best_known = false;
+    }
+
+    /**
+     * @brief delete the top element.
+     * @throws container_is_empty if empty() returns true
+     */
+    void pop() {
+        if (empty()) throw container_is_empty();
+        locate();
+        remove_top();
+    }
+
+    /**
+     * @brief delete the top element and return it.
+     * @throws container_is_empty if empty() returns true
+     */
+    T pop_value() {
+        if (empty()) throw container_is_empty();
+        locate();
+        T value = best == max_runs ? heap[0] : head(runs[best]);
+        remove_top();
+        return value;
+    }
+
+    /**
+     * @brief bytes written to disk so far, by spills and merges.
+     */
+    size_t bytes_written() const {
+        return written;
+    }
+
+    /**
+     * @brief bytes read from disk so far.
+     */
+    size_t bytes_read() const {
+        return read;
+    }
+
+    /**
+     * @brief the number of runs on disk.
+     */
+    size_t run_count() const {
+        return run_total;
+    }
+
+    /**
+     * @brief the budget the queue was made with, in bytes.
+     */
+    size_t memory_budget() const {
+        return budget;
+    }
+
+    /**
+     * @brief a copy of the comparator that orders the queue.
+     */
+    Compare value_comp() const {
+        return cmp;
+    }
+
+    /**
+     * @brief return the number of elements in the queue.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @brief check if the queue is empty.
+     */
+    bool empty() const {
+        return _size == 0;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
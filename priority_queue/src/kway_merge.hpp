@@ -0,0 +1,378 @@
+#ifndef SJTU_KWAY_MERGE_HPP
+#define SJTU_KWAY_MERGE_HPP
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "exceptions.hpp"
+
+namespace sjtu {
+/**
+ * @brief merges k sorted runs, each given as a pair of input iterators,
+ * into one sorted stream, without allocating per element.
+ *
+ * Each run must be sorted by Compare, smallest first, as for std::merge,
+ * and the merged stream is sorted the same way. Equal elements come out in
+ * the order of their runs, then in their order within a run, so the merge
+ * is stable.
+ *
+ * This is a loser tree. With k runs rounded up to a power of two p, run i
+ * is leaf p + i of a perfect binary tree whose inner nodes 1 to p - 1 each
+ * remember the run that lost the match played there, and node 0 the overall
+ * winner. Taking the winner's element and moving its run on replays only
+ * the matches on the path from its leaf to the root: ceil(log2(k))
+ * comparisons against the losers stored there, fewer when some runs have
+ * ended. Since the left subtree of a node holds the earlier runs, which
+ * side the path comes from settles ties. The tree is built on first use,
+ * with fewer than p comparisons, and again after add().
+ *
+ * Small trivial elements, such as numbers, are copied into the tree as
+ * their runs reach them, so a match reads only the tree. Other elements
+ * are read through the iterators.
+ *
+ * **Exception Safety**: if writing an element throws, the merge is as it
+ * was. If `Compare` throws, runtime_error is thrown and the tree is built
+ * afresh on next use, so the merge carries on from where it stopped; the
+ * element that was written last stays written.
+ */
+template <class InputIt,
+          class Compare =
+              std::less<typename std::iterator_traits<InputIt>::value_type>>
+class kway_merge {
+   public:
+    typedef typename std::iterator_traits<InputIt>::value_type value_type;
+
+   private:
+    // how many elements merge_batched() hands to a sink at once
+    static const size_t batch_size = 256;
+
+    // whether the tree keeps a copy of the element each run is at
+    static constexpr bool copies_heads =
+        std::is_trivial_v<value_type> &&
+        sizeof(value_type) <= 2 * sizeof(void*);
+
+    // the run of a tree entry once it has ended
+    static const size_t ended_run = size_t(-1);
+
+    struct run {
+        InputIt cur;
+        InputIt end;
+    };
+
+    struct no_head {};
+
+    struct entry {
+        size_t run;
+        [[no_unique_address]] std::conditional_t<copies_heads, value_type,
+                                                 no_head> head;
+    };
+
+    run* runs;
+    size_t k;
+    size_t capacity;
+    // tree[0] is the winning run and tree[1, leaves) the losing runs;
+    // built when first needed. Leaves past the runs are ended runs.
+    mutable entry* tree;
+    mutable size_t leaves;
+    mutable bool built;
+    [[no_unique_address]] Compare cmp;
+
+    static run* allocate(size_t n) {
+        return static_cast<run*>(
+            operator new(n * sizeof(run), std::align_val_t(alignof(run))));
+    }
+
+    static void deallocate(run* p) {
+        if (p) operator delete(p, std::align_val_t(alignof(run)));
+    }
+
+    /**
+     * @brief the entry of run i, ended_run if it has ended.
+     */
+    entry leaf(size_t i) const {
+        entry e{};
+        if (i >= k || runs[i].cur == runs[i].end) {
+            e.run = ended_run;
+            return e;
+        }
+        e.run = i;
+        if constexpr (copies_heads) e.head = *runs[i].cur;
+        return e;
+    }
+
+    const value_type& head(const entry& e) const {
+        if constexpr (copies_heads) {
+            return e.head;
+        } else {
+            return *runs[e.run].cur;
+        }
+    }
+
+    /**
+     * @brief whether the earlier run's entry a beats the later run's entry
+     * b: b is smaller, or on a tie a wins. An ended run loses to every
+     * other.
+     */
+    bool beats(const entry& a, const entry& b) const {
+        if (b.run == ended_run) return true;
+        if (a.run == ended_run) return false;
+        return !cmp(head(b), head(a));
+    }
+
+    /**
+     * @brief play every match bottom up. The winners of the inner nodes
+     * are kept in the upper half of the tree while it is built.
+     */
+    void build() const {
+        size_t p = 1;
+        while (p < k) p *= 2;
+        if (p != leaves) {
+            entry* fresh = new entry[2 * p];
+            delete[] tree;
+            tree = fresh;
+            leaves = p;
+        }
+        entry* winner = tree + p;
+        try {
+            for (size_t node = p; node-- > 1;) {
+                size_t left = 2 * node, right = left + 1;
+                entry a = left >= p ? leaf(left - p) : winner[left];
+                entry b = right >= p ? leaf(right - p) : winner[right];
+                bool left_wins = beats(a, b);
+                winner[node] = left_wins ? a : b;
+                tree[node] = left_wins ? b : a;
+            }
+        } catch (...) {
+            throw runtime_error();
+        }
+        tree[0] = p == 1 ? leaf(0) : winner[1];
+        built = true;
+    }
+
+    void ensure_built() const {
+        if (!built) build();
+    }
+
+    /**
+     * @brief whether the live entry stored at a node beats the live entry
+     * mine, carried up from the right child if from_right, where the
+     * stored one is the earlier run. Copied heads are put in order by
+     * indexing, not branching: which side a path comes from is a coin
+     * toss that a branch would mispredict.
+     */
+    bool stored_wins(const entry& stored, const entry& mine,
+                     bool from_right) const {
+        if constexpr (copies_heads) {
+            const value_type both[2] = {stored.head, mine.head};
+            return cmp(both[from_right], both[!from_right]) != from_right;
+        } else if (from_right) {
+            return !cmp(head(mine), head(stored));
+        } else {
+            return cmp(head(stored), head(mine));
+        }
+    }
+
+    /**
+     * @brief replay the matches on the path of run i, which has just moved
+     * on, from its leaf to the root.
+     */
+    void replay(size_t i) {
+        entry mine = leaf(i);
+        try {
+            for (size_t child = leaves + i; child > 1; child /= 2) {
+                entry& slot = tree[child / 2];
+                entry stored = slot;
+                if (stored.run == ended_run) continue;
+                bool swap = mine.run == ended_run ||
+                            stored_wins(stored, mine, child & 1);
+                // indexed rather than branched on, like the heads
+                const entry both[2] = {stored, mine};
+                slot = both[swap];
+                mine = both[!swap];
+            }
+        } catch (...) {
+            built = false;
+            throw runtime_error();
+        }
+        tree[0] = mine;
+    }
+
+    /**
+     * @brief move the winning run on past the element just taken.
+     */
+    void advance() {
+        size_t i = tree[0].run;
+        ++runs[i].cur;
+        replay(i);
+    }
+
+    /**
+     * @brief hand batch[0, n) to sink and empty it.
+     */
+    template <class Sink>
+    static void flush(Sink& sink, value_type* batch, size_t& n) {
+        const value_type* first = batch;
+        sink.push_batch(first, first + n);
+        while (n > 0) batch[--n].~value_type();
+    }
+
+   public:
+    /**
+     * @brief a merge of no runs.
+     */
+    explicit kway_merge(const Compare& compare = Compare())
+        : runs(nullptr),
+          k(0),
+          capacity(0),
+          tree(nullptr),
+          leaves(0),
+          built(false),
+          cmp(compare) {
+    }
+
+    // the runs are read once, so a merge is not copied
+    kway_merge(const kway_merge&) = delete;
+    kway_merge& operator=(const kway_merge&) = delete;
+
+    /**
+     * @brief deconstructor
+     */
+    ~kway_merge() {
+        for (size_t i = 0; i < k; ++i) runs[i].~run();
+        deallocate(runs);
+        delete[] tree;
+    }
+
+    /**
+     * @brief add the sorted run [first, last). The runs are numbered in the
+     * order they are added, which orders equal elements.
+     */
+    void add(InputIt first, InputIt last) {
+        if (k == capacity) {
+            size_t grown = capacity ? 2 * capacity : 8;
+            run* fresh = allocate(grown);
+            size_t moved = 0;
+            try {
+                for (; moved < k; ++moved) {
+                    new (fresh + moved)
+                        run(std::move_if_noexcept(runs[moved]));
+                }
+                new (fresh + k) run{std::move(first), std::move(last)};
+            } catch (...) {
+                while (moved > 0) fresh[--moved].~run();
+                deallocate(fresh);
+                throw;
+            }
+            for (size_t i = 0; i < k; ++i) runs[i].~run();
+            deallocate(runs);
+            runs = fresh;
+            capacity = grown;
+        } else {
+            new (runs + k) run{std::move(first), std::move(last)};
+        }
+        ++k;
+        built = false;
+    }
+
+    /**
+     * @brief the next element of the merged stream.
+     * @throws container_is_empty if empty() returns true
+     */
+    const value_type& top() const {
+        if (empty()) throw container_is_empty();
+        return head(tree[0]);
+    }
+
+    /**
+     * @brief skip the next element of the merged stream.
+     * @throws container_is_empty if empty() returns true
+     */
+    void pop() {
+        if (empty()) throw container_is_empty();
+        advance();
+    }
+
+    /**
+     * @brief write the rest of the merged stream to out.
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt merge(OutputIt out) {
+        if (empty()) return out;
+        while (tree[0].run != ended_run) {
+            *out = head(tree[0]);
+            ++out;
+            advance();
+        }
+        return out;
+    }
+
+    /**
+     * @brief hand the rest of the merged stream to sink in batches of up to
+     * 256 elements, by calls to sink.push_batch(first, last) with
+     * first and last pointers to const value_type. A batch is only valid
+     * during the call. If push_batch throws, the elements of that batch
+     * count as taken. If `Compare` throws, the elements taken so far are
+     * handed over before runtime_error is thrown.
+     */
+    template <class Sink>
+    void merge_batched(Sink& sink) {
+        if (empty()) return;
+        value_type* batch = static_cast<value_type*>(
+            operator new(batch_size * sizeof(value_type),
+                         std::align_val_t(alignof(value_type))));
+        size_t n = 0;
+        try {
+            while (tree[0].run != ended_run) {
+                new (batch + n) value_type(head(tree[0]));
+                ++n;
+                try {
+                    advance();
+                } catch (runtime_error&) {
+                    // the batch has left its runs already
+                    flush(sink, batch, n);
+                    throw;
+                }
+                if (n == batch_size || tree[0].run == ended_run) {
+                    flush(sink, batch, n);
+                }
+            }
+        } catch (...) {
+            while (n > 0) batch[--n].~value_type();
+            operator delete(batch, std::align_val_t(alignof(value_type)));
+            throw;
+        }
+        operator delete(batch, std::align_val_t(alignof(value_type)));
+    }
+
+    /**
+     * @brief a copy of the comparator the runs are sorted by.
+     */
+    Compare value_comp() const {
+        return cmp;
+    }
+
+    /**
+     * @brief return the number of runs added, ended or not.
+     */
+    size_t run_count() const {
+        return k;
+    }
+
+    /**
+     * @brief check if every run has ended.
+     */
+    bool empty() const {
+        if (k == 0) return true;
+        ensure_built();
+        return tree[0].run == ended_run;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,346 @@
+#ifndef SJTU_MIN_MAX_HEAP_HPP
+#define SJTU_MIN_MAX_HEAP_HPP
+
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <utility>
+
+#include "exceptions.hpp"
+
+namespace sjtu {
+/**
+ * @brief a double-ended priority queue: min() and max() in O(1), push,
+ * pop_min() and pop_max() in O(log n), all in one contiguous array.
+ * It replaces a pair of priority_queues kept in sync.
+ *
+ * This is Atkinson's min-max heap: nodes on even levels are no greater
+ * than their descendants, nodes on odd levels no less, so the least element
+ * is the root and the greatest one of its children.
+ *
+ * **Exception Safety**: as for priority_queue, if `Compare` throws, the
+ * operation is abandoned, runtime_error is thrown and the heap is left as
+ * it was. Every operation decides its moves with comparisons first.
+ */
+template <typename T, class Compare = std::less<T>>
+class min_max_heap {
+   private:
+    // a root-to-leaf path of a binary heap has fewer than 64 nodes
+    static const size_t max_depth = 64;
+
+    T* data;
+    size_t _size;
+    size_t capacity;
+    [[no_unique_address]] Compare cmp;
+
+    static T* allocate(size_t n) {
+        return static_cast<T*>(
+            operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    static void deallocate(T* p) {
+        if (p) operator delete(p, std::align_val_t(alignof(T)));
+    }
+
+    void destroy_all() {
+        for (size_t i = 0; i < _size; ++i) data[i].~T();
+        deallocate(data);
+        data = nullptr;
+        _size = capacity = 0;
+    }
+
+    /**
+     * @brief copy (or move, when that cannot throw) the elements into new
+     * storage of at least n slots, keeping the old storage on failure.
+     */
+    void reserve(size_t n) {
+        if (n <= capacity) return;
+        size_t grown = capacity < 8 ? 8 : capacity * 2;
+        if (grown < n) grown = n;
+        T* fresh = allocate(grown);
+        size_t built = 0;
+        try {
+            for (; built < _size; ++built) {
+                new (fresh + built) T(std::move_if_noexcept(data[built]));
+            }
+        } catch (...) {
+            for (size_t i = 0; i < built; ++i) fresh[i].~T();
+            deallocate(fresh);
+            throw;
+        }
+        for (size_t i = 0; i < _size; ++i) data[i].~T();
+        deallocate(data);
+        data = fresh;
+        capacity = grown;
+    }
+
+    static bool on_min_level(size_t i) {
+        return (std::bit_width(i + 1) & 1) == 1;
+    }
+
+    /**
+     * @brief whether a belongs above b on a level of the given kind.
+     */
+    bool above(const T& a, const T& b, bool min_level) const {
+        return min_level ? cmp(a, b) : cmp(b, a);
+    }
+
+    // one level of a trickle-down: the node at from moves up two levels
+    // (or one, for a child), and the carried element may trade places with
+    // from's parent on the way
+    struct step {
+        size_t from;
+        bool trade;
+    };
+
+    /**
+     * @brief plan how the element at carried sinks from slot i through
+     * h[0, n), with comparisons only: nothing moves while planning, and
+     * the slots a trade would overwrite are never compared again.
+     * @return the number of steps
+     */
+    size_t plan_down(size_t i, size_t n, const T* carried, step* steps) const {
+        bool min_level = on_min_level(i);
+        size_t depth = 0;
+        while (2 * i + 1 < n) {
+            size_t m = 2 * i + 1;
+            size_t candidates[5] = {2 * i + 2, 4 * i + 3, 4 * i + 4, 4 * i + 5,
+                                    4 * i + 6};
+            for (size_t k : candidates) {
+                if (k < n && above(data[k], data[m], min_level)) m = k;
+            }
+            if (!above(data[m], *carried, min_level)) break;
+            if (m <= 2 * i + 2) {
+                // a child: it is extreme among its own children too
+                steps[depth++] = step{m, false};
+                break;
+            }
+            size_t parent = (m - 1) / 2;
+            bool trade = above(*carried, data[parent], !min_level);
+            steps[depth++] = step{m, trade};
+            if (trade) carried = data + parent;
+            i = m;
+        }
+        return depth;
+    }
+
+    /**
+     * @brief remove the element at slot i, refilling it from the last one.
+     */
+    void remove_at(size_t i) {
+        size_t last = _size - 1;
+        if (i == last) {
+            data[last].~T();
+            --_size;
+            return;
+        }
+        step steps[max_depth];
+        size_t depth;
+        try {
+            depth = plan_down(i, last, data + last, steps);
+        } catch (...) {
+            throw runtime_error();
+        }
+        T carried(std::move(data[last]));
+        for (size_t d = 0; d < depth; ++d) {
+            data[i] = std::move(data[steps[d].from]);
+            i = steps[d].from;
+            if (steps[d].trade) std::swap(carried, data[(i - 1) / 2]);
+        }
+        data[i] = std::move(carried);
+        data[last].~T();
+        --_size;
+    }
+
+    /**
+     * @brief the slot of the greatest element.
+     */
+    size_t max_index() const {
+        if (_size == 1) return 0;
+        if (_size == 2) return 1;
+        bool right;
+        try {
+            right = cmp(data[1], data[2]);
+        } catch (...) {
+            throw runtime_error();
+        }
+        return right ? 2 : 1;
+    }
+
+    void copy_from(const min_max_heap& other) {
+        if (other._size == 0) return;
+        T* fresh = allocate(other._size);
+        size_t built = 0;
+        try {
+            for (; built < other._size; ++built) {
+                new (fresh + built) T(other.data[built]);
+            }
+        } catch (...) {
+            for (size_t i = 0; i < built; ++i) fresh[i].~T();
+            deallocate(fresh);
+            throw;
+        }
+        data = fresh;
+        _size = capacity = other._size;
+    }
+
+   public:
+    /**
+     * @brief default constructor
+     */
+    min_max_heap() : data(nullptr), _size(0), capacity(0), cmp() {
+    }
+
+    /**
+     * @brief an empty heap ordered by a copy of compare.
+     */
+    explicit min_max_heap(const Compare& compare)
+        : data(nullptr), _size(0), capacity(0), cmp(compare) {
+    }
+
+    /**
+     * @brief copy constructor
+     */
+    min_max_heap(const min_max_heap& other)
+        : data(nullptr), _size(0), capacity(0), cmp(other.cmp) {
+        copy_from(other);
+    }
+
+    /**
+     * @brief deconstructor
+     */
+    ~min_max_heap() {
+        destroy_all();
+    }
+
+    /**
+     * @brief Assignment operator
+     */
+    min_max_heap& operator=(const min_max_heap& other) {
+        if (this == &other) return *this;
+        destroy_all();
+        copy_from(other);
+        cmp = other.cmp;
+        return *this;
+    }
+
+    /**
+     * @brief the least element.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& min() const {
+        if (empty()) throw container_is_empty();
+        return data[0];
+    }
+
+    /**
+     * @brief the greatest element.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& max() const {
+        if (empty()) throw container_is_empty();
+        return data[max_index()];
+    }
+
+    /**
+     * @brief push new element to the heap.
+     */
+    void push(const T& e) {
+        emplace(e);
+    }
+
+    /**
+     * @brief push an element, moving from e.
+     */
+    void push(T&& e) {
+        emplace(std::move(e));
+    }
+
+    /**
+     * @brief push an element constructed in place from args. The slots it
+     * bubbles through are decided before anything moves.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        T value(std::forward<Args>(args)...);
+        reserve(_size + 1);
+        size_t chain[max_depth];
+        size_t length = 0;
+        size_t i = _size;
+        chain[length++] = i;
+        try {
+            if (i > 0) {
+                size_t parent = (i - 1) / 2;
+                bool min_level = on_min_level(i);
+                // past its parent, it belongs to the other kind of level
+                if (above(value, data[parent], !min_level)) {
+                    chain[length++] = parent;
+                    i = parent;
+                    min_level = !min_level;
+                }
+                while (i >= 3) {
+                    size_t grandparent = ((i - 1) / 2 - 1) / 2;
+                    if (!above(value, data[grandparent], min_level)) break;
+                    chain[length++] = grandparent;
+                    i = grandparent;
+                }
+            }
+        } catch (...) {
+            throw runtime_error();
+        }
+        if (length == 1) {
+            new (data + _size) T(std::move(value));
+        } else {
+            new (data + _size) T(std::move(data[chain[1]]));
+            for (size_t k = 1; k + 1 < length; ++k) {
+                data[chain[k]] = std::move(data[chain[k + 1]]);
+            }
+            data[chain[length - 1]] = std::move(value);
+        }
+        ++_size;
+    }
+
+    /**
+     * @brief delete the least element.
+     * @throws container_is_empty if empty() returns true
+     */
+    void pop_min() {
+        if (empty()) throw container_is_empty();
+        remove_at(0);
+    }
+
+    /**
+     * @brief delete the greatest element.
+     * @throws container_is_empty if empty() returns true
+     */
+    void pop_max() {
+        if (empty()) throw container_is_empty();
+        remove_at(max_index());
+    }
+
+    /**
+     * @brief a copy of the comparator that orders the heap.
+     */
+    Compare value_comp() const {
+        return cmp;
+    }
+
+    /**
+     * @brief return the number of elements.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @brief check if the container is empty.
+     */
+    bool empty() const {
+        return _size == 0;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
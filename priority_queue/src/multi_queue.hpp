@@ -0,0 +1,252 @@
+#ifndef SJTU_MULTI_QUEUE_HPP
+#define SJTU_MULTI_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include "dary_heap.hpp"
+#include "exceptions.hpp"
+#include "priority_queue.hpp"
+
+namespace sjtu {
+/**
+ * @brief a relaxed concurrent priority queue (a MultiQueue) for schedulers
+ * that outgrow one heap behind one mutex.
+ *
+ * Elements are spread over factor * threads shards, each a priority_queue
+ * behind its own spin lock on its own cache line. push locks one random
+ * free shard; try_pop locks two random shards and pops the better of their
+ * tops. Threads therefore rarely meet on a lock, at the price of order: a
+ * pop returns one of the O(factor * threads) best elements in expectation
+ * rather than the best. factor is the knob: 1 is the fastest and loosest,
+ * larger values trade throughput for rank quality only mildly, since the
+ * two-choice rule keeps the shards balanced.
+ *
+ * All members may be called concurrently, except construction and
+ * destruction. size() and empty() are only snapshots under concurrency.
+ *
+ * **Exception Safety**: if `Compare` throws, the shard involved is restored
+ * as priority_queue promises, its lock is released and runtime_error is
+ * thrown.
+ */
+template <typename T, class Compare = std::less<T>,
+          class Engine = dary_heap<4>>
+class multi_queue {
+   private:
+    typedef priority_queue<T, Compare, Engine> heap_type;
+
+    struct alignas(64) shard {
+        std::atomic<bool> locked;
+        heap_type heap;
+
+        explicit shard(const Compare& compare)
+            : locked(false), heap(compare) {
+        }
+
+        bool try_lock() {
+            return !locked.load(std::memory_order_relaxed) &&
+                   !locked.exchange(true, std::memory_order_acquire);
+        }
+        void lock() {
+            while (!try_lock()) std::this_thread::yield();
+        }
+        void unlock() {
+            locked.store(false, std::memory_order_release);
+        }
+    };
+
+    // releases the shards it holds when it goes out of scope
+    class guard {
+       private:
+        shard* held[2];
+
+       public:
+        guard() : held{nullptr, nullptr} {
+        }
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+        ~guard() {
+            if (held[0]) held[0]->unlock();
+            if (held[1]) held[1]->unlock();
+        }
+        void hold(shard* s) {
+            held[held[0] ? 1 : 0] = s;
+        }
+    };
+
+    shard* shards;
+    size_t shard_total;
+    std::atomic<size_t> count;
+    [[no_unique_address]] Compare cmp;
+
+    static shard* allocate(size_t n) {
+        return static_cast<shard*>(
+            operator new(n * sizeof(shard), std::align_val_t(alignof(shard))));
+    }
+
+    static void deallocate(shard* p) {
+        operator delete(p, std::align_val_t(alignof(shard)));
+    }
+
+    /**
+     * @brief a per-thread xorshift stream mapped onto [0, n).
+     */
+    static size_t random_index(size_t n) {
+        thread_local std::uint64_t state =
+            (std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+             0x9e3779b97f4a7c15ULL) |
+            1;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<size_t>(((state >> 32) * n) >> 32);
+    }
+
+    /**
+     * @brief pop the better top of s and t (either may be empty; t may be
+     * null) into out. Both must be held.
+     */
+    bool pop_better(shard* s, shard* t, T& out) {
+        shard* best = s;
+        if (t && !t->heap.empty()) {
+            if (s->heap.empty()) {
+                best = t;
+            } else {
+                bool worse;
+                try {
+                    worse = cmp(s->heap.top(), t->heap.top());
+                } catch (...) {
+                    throw runtime_error();
+                }
+                if (worse) best = t;
+            }
+        }
+        if (best->heap.empty()) return false;
+        out = best->heap.pop_value();
+        count.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+   public:
+    /**
+     * @brief an empty queue sized for the given number of threads.
+     * @param threads the number of threads expected to use it
+     * @param factor shards per thread; lower is faster, higher more exact
+     */
+    explicit multi_queue(size_t threads = std::thread::hardware_concurrency(),
+                         size_t factor = 2, const Compare& compare = Compare())
+        : shards(nullptr), shard_total(0), count(0), cmp(compare) {
+        size_t n = (threads ? threads : 1) * (factor ? factor : 1);
+        // two choices need two shards
+        if (n < 2) n = 2;
+        shards = allocate(n);
+        try {
+            for (; shard_total < n; ++shard_total) {
+                new (shards + shard_total) shard(compare);
+            }
+        } catch (...) {
+            for (size_t i = 0; i < shard_total; ++i) shards[i].~shard();
+            deallocate(shards);
+            throw;
+        }
+    }
+
+    multi_queue(const multi_queue&) = delete;
+    multi_queue& operator=(const multi_queue&) = delete;
+
+    /**
+     * @brief deconstructor
+     */
+    ~multi_queue() {
+        for (size_t i = 0; i < shard_total; ++i) shards[i].~shard();
+        deallocate(shards);
+    }
+
+    /**
+     * @brief push new element into a random shard.
+     */
+    void push(const T& e) {
+        emplace(e);
+    }
+
+    /**
+     * @brief push an element, moving from e.
+     */
+    void push(T&& e) {
+        emplace(std::move(e));
+    }
+
+    /**
+     * @brief push an element constructed in place from args.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        shard* s;
+        do {
+            s = shards + random_index(shard_total);
+        } while (!s->try_lock());
+        guard held;
+        held.hold(s);
+        s->heap.emplace(std::forward<Args>(args)...);
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief pop an element close to the top into out.
+     * Random pairs of shards are tried first; if none of them yields
+     * anything, every shard is visited in turn, so false means the queue
+     * was seen empty.
+     * @return whether an element was popped
+     */
+    bool try_pop(T& out) {
+        if (empty()) return false;
+        for (size_t attempt = 0; attempt < shard_total; ++attempt) {
+            size_t i = random_index(shard_total);
+            size_t j = random_index(shard_total - 1);
+            if (j >= i) ++j;
+            guard held;
+            if (!shards[i].try_lock()) continue;
+            held.hold(shards + i);
+            if (!shards[j].try_lock()) continue;
+            held.hold(shards + j);
+            if (pop_better(shards + i, shards + j, out)) return true;
+        }
+        for (size_t i = 0; i < shard_total; ++i) {
+            guard held;
+            shards[i].lock();
+            held.hold(shards + i);
+            if (pop_better(shards + i, nullptr, out)) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief the number of elements (a snapshot under concurrency).
+     */
+    size_t size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief check if the container is empty (a snapshot under concurrency).
+     */
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /**
+     * @brief the number of internal heaps.
+     */
+    size_t shard_count() const {
+        return shard_total;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
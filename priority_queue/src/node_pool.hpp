@@ -0,0 +1,219 @@
+#ifndef SJTU_NODE_POOL_HPP
+#define SJTU_NODE_POOL_HPP
+
+#include <cstddef>
+#include <new>
+
+namespace sjtu {
+/**
+ * @brief a slab allocator for the nodes of a linked container.
+ * Storage is carved out of geometrically growing slabs and recycled through
+ * an intrusive free list, so steady-state allocation is a pointer pop and no
+ * call into malloc. Releasing the pool frees whole slabs, without visiting
+ * the nodes in them.
+ *
+ * A pool is reference counted by the containers (and shared handles) that
+ * draw from it. Nodes may move between containers only when their pools are
+ * the same, so merging two containers first unites their pools: the slabs of
+ * one are spliced into the other in O(1), and the emptied pool forwards to
+ * the survivor until its last holder lets go. Holders re-resolve through
+ * find(), which follows and shortens such forwarding chains.
+ *
+ * A pool is not thread-safe; containers sharing one must stay on one thread.
+ */
+template <class Node>
+class node_pool {
+   private:
+    union slot {
+        slot* next;
+        alignas(Node) unsigned char storage[sizeof(Node)];
+    };
+
+    static const size_t first_slab_slots = 32;
+    static const size_t max_slab_slots = 1 << 16;
+
+    size_t refs;
+    bool shared;
+    node_pool* forward;
+    // slot 0 of every slab is its header and links to the next slab
+    slot* slabs;
+    slot* slabs_tail;
+    slot* free_head;
+    slot* free_tail;
+    slot* bump;
+    slot* bump_end;
+    size_t next_slab_slots;
+
+    node_pool()
+        : refs(1),
+          shared(false),
+          forward(nullptr),
+          slabs(nullptr),
+          slabs_tail(nullptr),
+          free_head(nullptr),
+          free_tail(nullptr),
+          bump(nullptr),
+          bump_end(nullptr),
+          next_slab_slots(first_slab_slots) {
+    }
+
+    node_pool(const node_pool&) = delete;
+    node_pool& operator=(const node_pool&) = delete;
+
+    ~node_pool() {
+        while (slabs) {
+            slot* next = slabs->next;
+            deallocate_slab(slabs);
+            slabs = next;
+        }
+    }
+
+    static slot* allocate_slab(size_t slots) {
+        if constexpr (alignof(slot) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return static_cast<slot*>(operator new(
+                slots * sizeof(slot), std::align_val_t(alignof(slot))));
+        } else {
+            return static_cast<slot*>(operator new(slots * sizeof(slot)));
+        }
+    }
+
+    static void deallocate_slab(slot* slab) {
+        if constexpr (alignof(slot) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            operator delete(slab, std::align_val_t(alignof(slot)));
+        } else {
+            operator delete(slab);
+        }
+    }
+
+    void grow() {
+        slot* slab = allocate_slab(next_slab_slots);
+        slab->next = nullptr;
+        if (slabs_tail) {
+            slabs_tail->next = slab;
+        } else {
+            slabs = slab;
+        }
+        slabs_tail = slab;
+        bump = slab + 1;
+        bump_end = slab + next_slab_slots;
+        if (next_slab_slots < max_slab_slots) next_slab_slots *= 2;
+    }
+
+   public:
+    /**
+     * @brief a new, empty pool with one reference held by the caller.
+     */
+    static node_pool* create() {
+        return new node_pool();
+    }
+
+    /**
+     * @brief the pool that p currently forwards to (p itself if none).
+     */
+    static node_pool* root_of(node_pool* p) {
+        while (p->forward) p = p->forward;
+        return p;
+    }
+
+    /**
+     * @brief resolve a holder's pool, moving its reference to the root.
+     */
+    static node_pool* find(node_pool*& p) {
+        if (!p->forward) return p;
+        node_pool* root = root_of(p);
+        root->retain();
+        release(p);
+        p = root;
+        return root;
+    }
+
+    void retain() {
+        ++refs;
+    }
+
+    /**
+     * @brief drop one reference; the last one frees every slab.
+     */
+    static void release(node_pool* p) {
+        while (p && --p->refs == 0) {
+            node_pool* next = p->forward;
+            delete p;
+            p = next;
+        }
+    }
+
+    /**
+     * @brief move every slab of other into this pool and forward other here.
+     * Both must be roots and distinct. O(1).
+     */
+    void unite(node_pool* other) {
+        if (other->slabs) {
+            if (slabs_tail) {
+                slabs_tail->next = other->slabs;
+            } else {
+                slabs = other->slabs;
+            }
+            slabs_tail = other->slabs_tail;
+        }
+        if (other->free_head) {
+            if (free_tail) {
+                free_tail->next = other->free_head;
+            } else {
+                free_head = other->free_head;
+            }
+            free_tail = other->free_tail;
+        }
+        // whatever is left of other's bump region is simply not reused
+        shared = shared || other->shared;
+        other->slabs = other->slabs_tail = nullptr;
+        other->free_head = other->free_tail = nullptr;
+        other->bump = other->bump_end = nullptr;
+        other->forward = this;
+        retain();
+    }
+
+    void mark_shared() {
+        shared = true;
+    }
+
+    bool is_shared() const {
+        return shared;
+    }
+
+    /**
+     * @brief true if the caller's reference is the only one, so releasing
+     * it will free the slabs together with every node still in them.
+     */
+    bool is_exclusive() const {
+        return refs == 1;
+    }
+
+    /**
+     * @brief raw, suitably aligned storage for one Node.
+     */
+    void* allocate() {
+        if (free_head) {
+            slot* s = free_head;
+            free_head = s->next;
+            if (!free_head) free_tail = nullptr;
+            return s;
+        }
+        if (bump == bump_end) grow();
+        return bump++;
+    }
+
+    /**
+     * @brief give back storage obtained from allocate() of this pool or of
+     * any pool united with it. The Node must already be destroyed.
+     */
+    void deallocate(void* p) {
+        slot* s = static_cast<slot*>(p);
+        s->next = free_head;
+        if (!free_head) free_tail = s;
+        free_head = s;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
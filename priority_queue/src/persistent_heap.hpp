@@ -0,0 +1,275 @@
+#ifndef SJTU_PERSISTENT_HEAP_HPP
+#define SJTU_PERSISTENT_HEAP_HPP
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "exceptions.hpp"
+
+namespace sjtu {
+/**
+ * @brief an immutable priority queue: push, pop and merge leave the heap
+ * they are called on untouched and return a new version, in O(log n).
+ * Copying a version is O(1), so a search that forks its state per branch
+ * no longer pays for a deep copy per fork.
+ *
+ * This is a leftist heap with path copying. Every node records the length
+ * of its right spine (its rank), and the right spine is never longer than
+ * the left, so it has at most log2(n + 1) nodes. An operation copies only
+ * the nodes on the spines it merges; everything else is shared between
+ * versions through reference counts. A version therefore costs memory in
+ * proportion to how far it departs from the versions it came from, and
+ * nodes are freed when the last version holding them goes away.
+ *
+ * Reference counts are not atomic: versions sharing nodes must stay on one
+ * thread.
+ *
+ * **Exception Safety**: versions are never modified, so if `Compare` or a
+ * copy of T throws, the nodes made so far are freed and every version is as
+ * it was. A throwing Compare surfaces as runtime_error.
+ */
+template <typename T, class Compare = std::less<T>>
+class persistent_heap {
+   private:
+    struct Node {
+        T data;
+        Node* left;
+        Node* right;
+        size_t refs;
+        // the number of nodes on the right spine, this one included
+        size_t rank;
+
+        template <class... Args>
+        explicit Node(Args&&... args)
+            : data(std::forward<Args>(args)...),
+              left(nullptr),
+              right(nullptr),
+              refs(1),
+              rank(1) {
+        }
+    };
+
+    // a right spine has at most log2(n + 1) < 64 nodes
+    static const size_t max_rank = 64;
+
+    Node* root;
+    size_t _size;
+    [[no_unique_address]] Compare cmp;
+
+    persistent_heap(Node* root, size_t size, const Compare& compare)
+        : root(root), _size(size), cmp(compare) {
+    }
+
+    static size_t rank_of(const Node* node) {
+        return node ? node->rank : 0;
+    }
+
+    static Node* retain(Node* node) {
+        if (node) ++node->refs;
+        return node;
+    }
+
+    /**
+     * @brief drop one reference to node, freeing whatever no other version
+     * holds, in O(1) extra space. A freed node with a left child is rotated
+     * right until it has none, as in priority_queue's clear. The nodes that
+     * are rotated into right links have a count of zero already, which
+     * tells them apart from genuine children that still need dropping.
+     */
+    static void release(Node* node) {
+        if (!node || --node->refs > 0) return;
+        Node* cur = node;
+        while (cur) {
+            Node* child = cur->left;
+            if (child) {
+                cur->left = nullptr;
+                if (--child->refs == 0) {
+                    cur->left = child->right;
+                    child->right = cur;
+                    cur = child;
+                }
+            } else {
+                Node* next = cur->right;
+                delete cur;
+                if (next && next->refs > 0 && --next->refs > 0) {
+                    next = nullptr;
+                }
+                cur = next;
+            }
+        }
+    }
+
+    /**
+     * @brief the merge of the heaps at a and b as a new reference; a and b
+     * are only read. The first pass walks down both right spines and only
+     * compares. The second copies the nodes it passed, bottom up, each new
+     * node sharing its source's left subtree.
+     */
+    Node* meld(Node* a, Node* b) const {
+        if (!a) return retain(b);
+        if (!b) return retain(a);
+        Node* path[2 * max_rank];
+        size_t depth = 0;
+        try {
+            while (a && b) {
+                if (cmp(a->data, b->data)) std::swap(a, b);
+                path[depth++] = a;
+                a = a->right;
+            }
+        } catch (...) {
+            throw runtime_error();
+        }
+        Node* cur = retain(a ? a : b);
+        try {
+            while (depth > 0) {
+                Node* source = path[--depth];
+                Node* node = new Node(source->data);
+                node->left = retain(source->left);
+                node->right = cur;
+                if (rank_of(node->left) < rank_of(node->right)) {
+                    std::swap(node->left, node->right);
+                }
+                node->rank = rank_of(node->right) + 1;
+                cur = node;
+            }
+        } catch (...) {
+            release(cur);
+            throw;
+        }
+        return cur;
+    }
+
+   public:
+    /**
+     * @brief an empty heap.
+     */
+    persistent_heap() : root(nullptr), _size(0), cmp() {
+    }
+
+    /**
+     * @brief an empty heap ordered by a copy of compare.
+     */
+    explicit persistent_heap(const Compare& compare)
+        : root(nullptr), _size(0), cmp(compare) {
+    }
+
+    /**
+     * @brief a snapshot of other, in O(1).
+     */
+    persistent_heap(const persistent_heap& other)
+        : root(retain(other.root)), _size(other._size), cmp(other.cmp) {
+    }
+
+    /**
+     * @brief deconstructor; frees the nodes no other version holds.
+     */
+    ~persistent_heap() {
+        release(root);
+    }
+
+    /**
+     * @brief Assignment operator, O(1) besides freeing what this version
+     * alone held.
+     */
+    persistent_heap& operator=(const persistent_heap& other) {
+        Node* old = root;
+        root = retain(other.root);
+        _size = other._size;
+        cmp = other.cmp;
+        release(old);
+        return *this;
+    }
+
+    /**
+     * @brief get the top element.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& top() const {
+        if (empty()) throw container_is_empty();
+        return root->data;
+    }
+
+    /**
+     * @brief a new version with e added.
+     */
+    persistent_heap push(const T& e) const {
+        return emplace(e);
+    }
+
+    /**
+     * @brief a new version with e added, moving from e.
+     */
+    persistent_heap push(T&& e) const {
+        return emplace(std::move(e));
+    }
+
+    /**
+     * @brief a new version with an element constructed from args added.
+     */
+    template <class... Args>
+    persistent_heap emplace(Args&&... args) const {
+        Node* single = new Node(std::forward<Args>(args)...);
+        Node* merged;
+        try {
+            merged = meld(root, single);
+        } catch (...) {
+            release(single);
+            throw;
+        }
+        release(single);
+        return persistent_heap(merged, _size + 1, cmp);
+    }
+
+    /**
+     * @brief a new version without the top element.
+     * @throws container_is_empty if empty() returns true
+     */
+    persistent_heap pop() const {
+        if (empty()) throw container_is_empty();
+        return persistent_heap(meld(root->left, root->right), _size - 1, cmp);
+    }
+
+    /**
+     * @brief a new version holding the elements of both heaps. Both must
+     * order elements the same way; this one's comparator is used.
+     */
+    persistent_heap merge(const persistent_heap& other) const {
+        return persistent_heap(meld(root, other.root), _size + other._size,
+                               cmp);
+    }
+
+    /**
+     * @brief exchange the contents of two versions, in O(1).
+     */
+    void swap(persistent_heap& other) {
+        std::swap(root, other.root);
+        std::swap(_size, other._size);
+        std::swap(cmp, other.cmp);
+    }
+
+    /**
+     * @brief a copy of the comparator that orders the heap.
+     */
+    Compare value_comp() const {
+        return cmp;
+    }
+
+    /**
+     * @brief return the number of elements.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @brief check if the heap is empty.
+     */
+    bool empty() const {
+        return _size == 0;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
@@ -2,83 +2,472 @@
 #define SJTU_PRIORITY_QUEUE_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #include "exceptions.hpp"
+#include "node_pool.hpp"
 
 namespace sjtu {
+/**
+ * @brief engine tag for priority_queue: a pointer-based skew heap.
+ * O(log n) amortized push, pop and merge. This is the default engine.
+ * Other engines (see dary_heap.hpp) live in their own headers.
+ */
+struct skew_heap {};
+
 /**
  * @brief a container like std::priority_queue which is a heap internal.
  * **Exception Safety**: The `Compare` operation might throw exceptions for
  * certain data. In such cases, any ongoing operation should be terminated, and
  * the priority queue should be restored to its original state before the
  * operation began.
+ * @tparam Engine the heap layout; every engine keeps this interface.
  */
-template <typename T, class Compare = std::less<T>>
-class priority_queue {
+template <typename T, class Compare = std::less<T>, class Engine = skew_heap>
+class priority_queue;
+
+template <typename T, class Compare>
+class priority_queue<T, Compare, skew_heap> {
    private:
     struct Node {
         T data;
         Node* left;
         Node* right;
 
-        Node(const T& data) : data(data), left(nullptr), right(nullptr) {
+        template <class... Args>
+        explicit Node(Args&&... args)
+            : data(std::forward<Args>(args)...), left(nullptr), right(nullptr) {
         }
     };
 
+    typedef node_pool<Node> pool_type;
+
     Node* root;
     size_t _size;
+    // where the nodes come from; created on first use
+    pool_type* pool;
+    // takes no space when Compare is empty
+    [[no_unique_address]] Compare cmp;
+
+    pool_type* node_source() {
+        if (!pool) pool = pool_type::create();
+        return pool_type::find(pool);
+    }
+
+    template <class... Args>
+    Node* create_node(Args&&... args) {
+        pool_type* source = node_source();
+        void* memory = source->allocate();
+        try {
+            return new (memory) Node(std::forward<Args>(args)...);
+        } catch (...) {
+            source->deallocate(memory);
+            throw;
+        }
+    }
+
+    void destroy_node(Node* node) {
+        node->~Node();
+        pool_type::find(pool)->deallocate(node);
+    }
 
-    void clear(Node*& node) {
-        if (node) {
-            clear(node->left);
-            clear(node->right);
-            delete node;
-            node = nullptr;
+    /**
+     * @brief destroy the subtree rooted at node in O(1) extra space.
+     * A node with a left child is rotated right until it has none, after
+     * which it can be destroyed and its right subtree taken next.
+     * @param recycle whether to hand the storage back to the pool; skip it
+     * when the whole pool is about to be freed anyway.
+     */
+    void clear(Node*& node, bool recycle = true) {
+        Node* cur = node;
+        while (cur) {
+            if (cur->left) {
+                Node* child = cur->left;
+                cur->left = child->right;
+                child->right = cur;
+                cur = child;
+            } else {
+                Node* next = cur->right;
+                if (recycle) {
+                    destroy_node(cur);
+                } else {
+                    cur->~Node();
+                }
+                cur = next;
+            }
         }
+        node = nullptr;
+    }
+
+    /**
+     * @brief drop every node together with this queue's hold on its pool.
+     * If no other queue draws from the pool, its slabs are freed as a whole:
+     * the nodes are only visited when T has a destructor to run.
+     */
+    void release() {
+        if (!pool) return;
+        if (!pool_type::find(pool)->is_exclusive()) {
+            clear(root);
+        } else if constexpr (!std::is_trivially_destructible_v<T>) {
+            clear(root, false);
+        }
+        root = nullptr;
+        pool_type::release(pool);
+        pool = nullptr;
     }
 
+    /**
+     * @brief make a into a deep copy of the subtree b, without recursion.
+     * The copy is built breadth first. Every node still waiting for its
+     * children borrows its own fields: left points at the source node it
+     * copies and right links it to the next waiting node.
+     */
     void copy(Node*& a, Node* b) {
-        if (!b) {
-            a = nullptr;
-            return;
+        a = nullptr;
+        if (!b) return;
+        a = create_node(b->data);
+        a->left = b;
+        Node* head = a;
+        Node* tail = a;
+        try {
+            while (head) {
+                Node* node = head;
+                Node* source = node->left;
+                head = node->right;
+                if (!head) tail = nullptr;
+                node->left = node->right = nullptr;
+                Node* children[2] = {source->left, source->right};
+                for (int i = 0; i < 2; ++i) {
+                    if (!children[i]) continue;
+                    Node* child = create_node(children[i]->data);
+                    (i == 0 ? node->left : node->right) = child;
+                    child->left = children[i];
+                    if (tail) {
+                        tail->right = child;
+                    } else {
+                        head = child;
+                    }
+                    tail = child;
+                }
+            }
+        } catch (...) {
+            // waiting nodes still hold borrowed links; cut them first
+            while (head) {
+                Node* next = head->right;
+                head->left = head->right = nullptr;
+                head = next;
+            }
+            clear(a);
+            throw;
         }
-        a = new Node(b->data);
-        copy(a->left, b->left);
-        copy(a->right, b->right);
     }
 
+    // merge paths are O(log n) amortized, so they nearly always fit here
+    static const size_t path_capacity = 64;
+
+    static Node* untagged(std::uintptr_t link) {
+        return reinterpret_cast<Node*>(link & ~std::uintptr_t(1));
+    }
+
+    /**
+     * @brief walk a merge path again from node, with rest the other heap,
+     * for steps whose outcomes merge() kept in right links, taking each
+     * out again. If link is set, the nodes are linked on the way as in
+     * merge(); the walk must then run to the end of the path.
+     */
+    static void replay(Node* node, Node* rest, size_t steps, bool link) {
+        for (size_t i = 0; i < steps; ++i) {
+            std::uintptr_t kept = reinterpret_cast<std::uintptr_t>(node->right);
+            Node* next = untagged(kept);
+            node->right = next;
+            if (kept & 1) std::swap(next, rest);
+            if (link) {
+                node->right = node->left;
+                node->left = next;
+            }
+            node = next;
+        }
+        if (link) {
+            node->right = node->left;
+            node->left = rest;
+        }
+    }
+
+    /**
+     * @brief merge two skew heaps without recursion or allocation.
+     * The first pass walks down the merged right spines and only compares,
+     * so a throwing Compare leaves both heaps exactly as they were. The
+     * second pass links the nodes it visited as the recursive definition
+     *   a->right = merge(a->right, b); swap(a->left, a->right);
+     * would on its way back up.
+     *
+     * The first nodes of the path are recorded inline. Should the path be
+     * longer, each further step records only whether the walk crossed over
+     * to the other heap there, in the low bit of the right link it was
+     * taken from: the walk has read that link already and the second pass
+     * rewrites it, and a link to a Node never has the bit set otherwise.
+     * The second pass, or the clean-up after a throw, walks that part again
+     * by those bits and clears them.
+     */
     Node* merge(Node* a, Node* b) {
+        static_assert(alignof(Node) > 1, "the low bit of a link is free");
         if (!a) return b;
         if (!b) return a;
-        if (Compare()(a->data, b->data)) std::swap(a, b);
-        a->right = merge(a->right, b);
-        std::swap(a->left, a->right);
+        if (cmp(a->data, b->data)) std::swap(a, b);
+        Node* path[path_capacity];
+        size_t length = 0;
+        path[length++] = a;
+        Node* node = a;
+        Node* rest = b;
+        // the other heap where the path outgrew path[], and the steps since
+        Node* spilled_rest = nullptr;
+        size_t spilled = 0;
+        try {
+            while (Node* next = node->right) {
+                Node* before = rest;
+                bool crossed = cmp(next->data, rest->data);
+                if (crossed) std::swap(next, rest);
+                if (length < path_capacity) {
+                    path[length++] = next;
+                } else {
+                    if (!spilled) spilled_rest = before;
+                    node->right = reinterpret_cast<Node*>(
+                        reinterpret_cast<std::uintptr_t>(node->right) |
+                        std::uintptr_t(crossed));
+                    ++spilled;
+                }
+                node = next;
+            }
+        } catch (...) {
+            if (spilled) {
+                replay(path[length - 1], spilled_rest, spilled, false);
+            }
+            throw;
+        }
+
+        size_t last = length - 1;
+        for (size_t i = 0; i < last; ++i) {
+            path[i]->right = path[i]->left;
+            path[i]->left = path[i + 1];
+        }
+        if (spilled) {
+            replay(path[last], spilled_rest, spilled, true);
+        } else {
+            path[last]->right = path[last]->left;
+            path[last]->left = rest;
+        }
         return a;
     }
 
+    /**
+     * @brief a heap of the elements of [first, last), built in O(n) like a
+     * binary counter: slot k holds a heap of 2^k elements, and a new element
+     * carries into the slots by melding equal sizes. Only new nodes are
+     * touched, and they are freed again if anything throws.
+     * @param count set to the number of elements read
+     */
+    template <class InputIt>
+    Node* build(InputIt first, InputIt last, size_t& count) {
+        Node* slots[64] = {};
+        Node* carry = nullptr;
+        Node* heap = nullptr;
+        bool melding = false;
+        count = 0;
+        try {
+            for (; first != last; ++first) {
+                carry = create_node(*first);
+                melding = true;
+                size_t k = 0;
+                for (; slots[k]; ++k) {
+                    carry = merge(slots[k], carry);
+                    slots[k] = nullptr;
+                }
+                melding = false;
+                slots[k] = carry;
+                carry = nullptr;
+                ++count;
+            }
+            melding = true;
+            for (size_t k = 0; k < 64; ++k) {
+                heap = merge(slots[k], heap);
+                slots[k] = nullptr;
+            }
+        } catch (...) {
+            clear(carry);
+            clear(heap);
+            for (size_t k = 0; k < 64; ++k) {
+                clear(slots[k]);
+            }
+            if (melding) throw runtime_error();
+            throw;
+        }
+        return heap;
+    }
+
+    /**
+     * @brief add node to f[0, n), a binary heap of nodes by their data used
+     * to walk the tree best first. Only the scratch array is written.
+     */
+    void frontier_push(Node** f, size_t& n, Node* node) const {
+        size_t i = n++;
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!cmp(f[parent]->data, node->data)) break;
+            f[i] = f[parent];
+            i = parent;
+        }
+        f[i] = node;
+    }
+
+    Node* frontier_pop(Node** f, size_t& n) const {
+        Node* best = f[0];
+        Node* moved = f[--n];
+        size_t i = 0;
+        while (2 * i + 1 < n) {
+            size_t child = 2 * i + 1;
+            if (child + 1 < n && cmp(f[child]->data, f[child + 1]->data)) {
+                ++child;
+            }
+            if (!cmp(moved->data, f[child]->data)) break;
+            f[i] = f[child];
+            i = child;
+        }
+        if (n > 0) f[i] = moved;
+        return best;
+    }
+
+    /**
+     * @brief stack count nodes, best first, on top of n <= count + 1 heaps
+     * whose elements are no greater than any of them. No comparisons: the
+     * nodes form a chain down their left links and hold one heap each on
+     * the right, the last one holding a second on the left.
+     * @return the new root
+     */
+    static Node* restack(Node** chain, size_t count, Node** heaps, size_t n) {
+        for (size_t j = 0; j < count; ++j) {
+            Node* node = chain[j];
+            if (j + 1 < count) {
+                node->left = chain[j + 1];
+            } else {
+                node->left = n > count ? heaps[count] : nullptr;
+            }
+            node->right = j < n ? heaps[j] : nullptr;
+        }
+        return chain[0];
+    }
+
    public:
     /**
      * @brief default constructor
      */
-    priority_queue() : root(nullptr), _size(0) {
+    priority_queue() : root(nullptr), _size(0), pool(nullptr), cmp() {
+    }
+
+    /**
+     * @brief an empty queue ordered by a copy of compare, which may carry
+     * state (a lambda capture, a pointer to a distance table, ...).
+     */
+    explicit priority_queue(const Compare& compare)
+        : root(nullptr), _size(0), pool(nullptr), cmp(compare) {
+    }
+
+    /**
+     * @brief a node pool that several queues can draw from.
+     * Queues built from the same handle recycle each other's nodes, and
+     * merging them never has to unite pools. Copying a handle shares it.
+     */
+    class shared_pool {
+       private:
+        pool_type* pool;
+        friend class priority_queue;
+
+       public:
+        shared_pool() : pool(pool_type::create()) {
+            pool->mark_shared();
+        }
+        shared_pool(const shared_pool& other) : pool(other.pool) {
+            pool->retain();
+        }
+        shared_pool& operator=(const shared_pool& other) {
+            other.pool->retain();
+            pool_type::release(pool);
+            pool = other.pool;
+            return *this;
+        }
+        ~shared_pool() {
+            pool_type::release(pool);
+        }
+    };
+
+    /**
+     * @brief an empty queue whose nodes come from a shared pool.
+     */
+    explicit priority_queue(const shared_pool& source,
+                            const Compare& compare = Compare())
+        : root(nullptr),
+          _size(0),
+          pool(pool_type::root_of(source.pool)),
+          cmp(compare) {
+        pool->retain();
+    }
+
+    /**
+     * @brief a queue of the elements of [first, last), built in O(n)
+     * instead of by n pushes.
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    priority_queue(InputIt first, InputIt last,
+                   const Compare& compare = Compare())
+        : root(nullptr), _size(0), pool(nullptr), cmp(compare) {
+        try {
+            root = build(first, last, _size);
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    /**
+     * @brief a queue of the elements of a container such as sjtu::vector.
+     */
+    template <class Container,
+              class = decltype(std::declval<const Container&>().begin())>
+    explicit priority_queue(const Container& elements,
+                            const Compare& compare = Compare())
+        : priority_queue(elements.begin(), elements.end(), compare) {
     }
 
     /**
      * @brief copy constructor
      * @param other the priority_queue to be copied
      */
-    priority_queue(const priority_queue& other) {
+    priority_queue(const priority_queue& other) : cmp(other.cmp) {
         root = nullptr;
         _size = other._size;
-        copy(root, other.root);
+        pool = nullptr;
+        // a copy keeps drawing from a shared pool, otherwise gets its own
+        if (other.pool && pool_type::root_of(other.pool)->is_shared()) {
+            pool = pool_type::root_of(other.pool);
+            pool->retain();
+        }
+        try {
+            copy(root, other.root);
+        } catch (...) {
+            release();
+            throw;
+        }
     }
 
     /**
      * @brief deconstructor
      */
     ~priority_queue() {
-        clear(root);
+        release();
     }
 
     /**
@@ -88,12 +477,44 @@ class priority_queue {
      */
     priority_queue& operator=(const priority_queue& other) {
         if (this == &other) return *this;
+        // build the copy first, so a failed one leaves the queue as it was
+        Node* fresh;
+        copy(fresh, other.root);
+        try {
+            cmp = other.cmp;
+        } catch (...) {
+            clear(fresh);
+            throw;
+        }
         clear(root);
+        root = fresh;
         _size = other._size;
-        copy(root, other.root);
         return *this;
     }
 
+    /**
+     * @brief replace the contents with the elements of [first, last) in
+     * O(n). If anything throws, the queue keeps its old contents.
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void assign(InputIt first, InputIt last) {
+        size_t count;
+        Node* fresh = build(first, last, count);
+        clear(root);
+        root = fresh;
+        _size = count;
+    }
+
+    /**
+     * @brief replace the contents with the elements of a container.
+     */
+    template <class Container,
+              class = decltype(std::declval<const Container&>().begin())>
+    void assign(const Container& elements) {
+        assign(elements.begin(), elements.end());
+    }
+
     /**
      * @brief get the top element of the priority queue.
      * @return a reference of the top element.
@@ -109,19 +530,62 @@ class priority_queue {
      * @param e the element to be pushed
      */
     void push(const T& e) {
+        emplace(e);
+    }
+
+    /**
+     * @brief push an element, moving from e.
+     */
+    void push(T&& e) {
+        emplace(std::move(e));
+    }
+
+    /**
+     * @brief push an element constructed in place from args.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
         Node* original_root = root;
-        Node* to_merge = new Node(e);
+        Node* to_merge = create_node(std::forward<Args>(args)...);
         try {
             root = merge(root, to_merge);
         } catch (...) {
             // back to original state
             root = original_root;
-            delete to_merge;
+            destroy_node(to_merge);
             throw runtime_error();
         }
         _size++;
     }
 
+    /**
+     * @brief push the elements of [first, last) at once: they are built
+     * into a heap of their own in O(m), which is then melded in with a
+     * single merge. If anything throws, the queue is left as it was.
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void push_range(InputIt first, InputIt last) {
+        size_t count;
+        Node* batch = build(first, last, count);
+        try {
+            root = merge(root, batch);
+        } catch (...) {
+            clear(batch);
+            throw runtime_error();
+        }
+        _size += count;
+    }
+
+    /**
+     * @brief push the elements of a container such as sjtu::vector.
+     */
+    template <class Container,
+              class = decltype(std::declval<const Container&>().begin())>
+    void push_range(const Container& elements) {
+        push_range(elements.begin(), elements.end());
+    }
+
     /**
      * @brief delete the top element from the priority queue.
      * @throws container_is_empty if empty() returns true
@@ -137,10 +601,111 @@ class priority_queue {
             throw runtime_error();
         }
 
-        delete tmp;
+        destroy_node(tmp);
         _size--;
     }
 
+    /**
+     * @brief remove the top element and return it, moved out rather than
+     * copied (unless T can only be moved by a throwing constructor).
+     * @throws container_is_empty if empty() returns true
+     */
+    T pop_value() {
+        if (empty()) throw container_is_empty();
+        Node* old = root;
+        Node* rest;
+        try {
+            rest = merge(old->left, old->right);
+        } catch (...) {
+            throw runtime_error();
+        }
+        // old stays on top of the merged children until its value is out
+        old->left = rest;
+        old->right = nullptr;
+        T value(std::move_if_noexcept(old->data));
+        root = rest;
+        destroy_node(old);
+        _size--;
+        return value;
+    }
+
+    /**
+     * @brief move the best min(k, size()) elements to out, best first, and
+     * remove them. Cheaper than k pops: the elements are picked by walking
+     * the tree best first over an array of node pointers, and the subtrees
+     * left hanging below them are melded once, pairwise, at the end.
+     * If Compare throws, the queue keeps all its elements. If writing to out
+     * throws, the elements not yet written stay in the queue.
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt pop_k(size_t k, OutputIt out) {
+        size_t count = k < _size ? k : _size;
+        if (count == 0) return out;
+        // the picked nodes, then the frontier: at most count + 1 subtrees
+        Node** picked = new Node*[2 * count + 1];
+        Node** forest = picked + count;
+        size_t trees = 0;
+        try {
+            frontier_push(forest, trees, root);
+            for (size_t j = 0; j < count; ++j) {
+                Node* best = frontier_pop(forest, trees);
+                picked[j] = best;
+                if (best->left) frontier_push(forest, trees, best->left);
+                if (best->right) frontier_push(forest, trees, best->right);
+            }
+        } catch (...) {
+            delete[] picked;
+            throw runtime_error();
+        }
+
+        size_t i = 0, melded = 0;
+        try {
+            while (trees > 1) {
+                for (i = 0, melded = 0; i + 1 < trees; i += 2) {
+                    Node* heap = merge(forest[i], forest[i + 1]);
+                    forest[melded++] = heap;
+                }
+                if (i < trees) forest[melded++] = forest[i];
+                trees = melded;
+            }
+        } catch (...) {
+            // forest[0, melded) and forest[i, trees) are whole heaps
+            for (; i < trees; ++i) forest[melded++] = forest[i];
+            root = restack(picked, count, forest, melded);
+            delete[] picked;
+            throw runtime_error();
+        }
+
+        root = trees ? forest[0] : nullptr;
+        size_t j = 0;
+        try {
+            for (; j < count; ++j) {
+                *out = std::move(picked[j]->data);
+                ++out;
+                destroy_node(picked[j]);
+                _size--;
+            }
+        } catch (...) {
+            Node* rest = root;
+            root = restack(picked + j, count - j, &rest, 1);
+            delete[] picked;
+            throw;
+        }
+        delete[] picked;
+        return out;
+    }
+
+    /**
+     * @brief move every element to out, best first, leaving the queue
+     * empty; a heap sort over node pointers, O(n log n).
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt drain_sorted(OutputIt out) {
+        return pop_k(_size, out);
+    }
+
     /**
      * @brief return the number of elements in the priority queue.
      * @return the number of elements.
@@ -157,28 +722,48 @@ class priority_queue {
         return _size == 0;
     }
 
+    /**
+     * @brief a copy of the comparator that orders the queue.
+     */
+    Compare value_comp() const {
+        return cmp;
+    }
+
     /**
      * @brief merge another priority_queue into this one.
      * The other priority_queue will be cleared after merging.
+     * Both queues must order elements the same way; this one's comparator
+     * is used.
      * The complexity is at most O(logn).
      * @param other the priority_queue to be merged.
      */
     void merge(priority_queue& other) {
-        Node* original_root = root;
-        Node* other_root = other.root;
-        size_t original_size = _size;
+        if (!other.root) return;
+
+        // nodes may only change queues within one pool, so unite the pools
+        // first (O(1)); a queue on a shared pool stays on it afterwards
+        bool other_shared = pool_type::find(other.pool)->is_shared();
+        if (!pool) {
+            pool = pool_type::find(other.pool);
+            pool->retain();
+        } else if (pool_type::find(pool) != pool_type::find(other.pool)) {
+            pool_type::find(pool)->unite(pool_type::find(other.pool));
+        }
 
         try {
             root = merge(root, other.root);
-            _size += other._size;
-            other.root = nullptr;
-            other._size = 0;
         } catch (...) {
-            // Restore original state
-            root = original_root;
-            other.root = other_root;
+            // merging allocates nothing, so only Compare can have thrown,
+            // and both heaps are as they were
             throw runtime_error();
         }
+        _size += other._size;
+        other.root = nullptr;
+        other._size = 0;
+        if (!other_shared) {
+            pool_type::release(other.pool);
+            other.pool = nullptr;
+        }
     }
 };
 
@@ -0,0 +1,420 @@
+#ifndef SJTU_RADIX_HEAP_HPP
+#define SJTU_RADIX_HEAP_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "exceptions.hpp"
+
+namespace sjtu {
+/**
+ * @brief maps a key to an unsigned code with the same order, so radix_heap
+ * can bucket keys by their bits. Specialize it for other key types.
+ */
+template <class Key, class = void>
+struct radix_key;
+
+template <class Key>
+struct radix_key<Key, std::enable_if_t<std::is_unsigned_v<Key>>> {
+    typedef Key code_type;
+
+    static code_type encode(Key key) {
+        return key;
+    }
+    static Key decode(code_type code) {
+        return code;
+    }
+};
+
+template <class Key>
+struct radix_key<Key, std::enable_if_t<std::is_integral_v<Key> &&
+                                       std::is_signed_v<Key>>> {
+    typedef std::make_unsigned_t<Key> code_type;
+    static constexpr code_type sign =
+        code_type(1) << (std::numeric_limits<code_type>::digits - 1);
+
+    // flipping the sign bit moves the negative keys below the others
+    static code_type encode(Key key) {
+        return static_cast<code_type>(static_cast<code_type>(key) ^ sign);
+    }
+    static Key decode(code_type code) {
+        return static_cast<Key>(static_cast<code_type>(code ^ sign));
+    }
+};
+
+template <class Key>
+struct radix_key<Key, std::enable_if_t<std::is_floating_point_v<Key>>> {
+    typedef std::conditional_t<sizeof(Key) == 4, std::uint32_t, std::uint64_t>
+        code_type;
+    static_assert(sizeof(Key) == sizeof(code_type),
+                  "only float and double keys have a code");
+    static constexpr code_type sign =
+        code_type(1) << (std::numeric_limits<code_type>::digits - 1);
+
+    // non-negative keys get the sign bit set; negative ones are inverted,
+    // so a larger magnitude gets a smaller code
+    static code_type encode(Key key) {
+        code_type bits = std::bit_cast<code_type>(key);
+        return (bits & sign) ? ~bits : bits | sign;
+    }
+    static Key decode(code_type code) {
+        return std::bit_cast<Key>((code & sign) ? code ^ sign : ~code);
+    }
+};
+
+/**
+ * @brief a min-queue of (key, value) pairs for monotone keys: every pushed
+ * key must be at least the last key returned by top(), top_key() or a pop.
+ * Shortest paths and event simulations have that shape, and pay for a
+ * general comparison heap they do not need.
+ *
+ * Keys are mapped to unsigned codes by radix_key (unsigned and signed
+ * integers, float and double out of the box). An element sits in the bucket
+ * numbered by the highest bit in which its code differs from the last key
+ * taken, so push is O(1) and pop O(log C) amortized, C being the range of
+ * codes: an element only ever moves to lower buckets. Emptied buckets keep
+ * their storage, so a steady workload stops allocating.
+ *
+ * **Exception Safety**: a push below the monotone floor throws
+ * runtime_error and changes nothing. If moving elements between buckets
+ * fails, they are put back and the heap is unchanged.
+ */
+template <class Key, class T>
+class radix_heap {
+   private:
+    typedef radix_key<Key> traits;
+    typedef typename traits::code_type code_type;
+    static const size_t bucket_count =
+        std::numeric_limits<code_type>::digits + 1;
+
+    struct item {
+        code_type code;
+        T value;
+
+        template <class... Args>
+        explicit item(code_type code, Args&&... args)
+            : code(code), value(std::forward<Args>(args)...) {
+        }
+    };
+
+    // a growable array that keeps its storage when emptied
+    struct bucket {
+        item* items;
+        size_t size;
+        size_t capacity;
+    };
+
+    // top() may redistribute a bucket: the contents stay the same
+    mutable bucket buckets[bucket_count];
+    // the code of the last key taken; bucket 0 holds exactly this code
+    mutable code_type last;
+    size_t _size;
+
+    static item* allocate(size_t n) {
+        return static_cast<item*>(
+            operator new(n * sizeof(item), std::align_val_t(alignof(item))));
+    }
+
+    static void deallocate(item* p) {
+        if (p) operator delete(p, std::align_val_t(alignof(item)));
+    }
+
+    /**
+     * @brief grow b to hold at least n items; b is unchanged on failure.
+     */
+    static void reserve(bucket& b, size_t n) {
+        if (n <= b.capacity) return;
+        size_t grown = b.capacity < 4 ? 4 : b.capacity * 2;
+        if (grown < n) grown = n;
+        item* fresh = allocate(grown);
+        size_t built = 0;
+        try {
+            for (; built < b.size; ++built) {
+                new (fresh + built) item(std::move_if_noexcept(b.items[built]));
+            }
+        } catch (...) {
+            for (size_t i = 0; i < built; ++i) fresh[i].~item();
+            deallocate(fresh);
+            throw;
+        }
+        for (size_t i = 0; i < b.size; ++i) b.items[i].~item();
+        deallocate(b.items);
+        b.items = fresh;
+        b.capacity = grown;
+    }
+
+    static void empty_out(bucket& b) {
+        for (size_t i = 0; i < b.size; ++i) b.items[i].~item();
+        b.size = 0;
+    }
+
+    size_t index_of(code_type code) const {
+        return std::bit_width(static_cast<code_type>(code ^ last));
+    }
+
+    /**
+     * @brief copy (or move, when that cannot throw) every item of the n
+     * source buckets into the bucket its code belongs to now. Room is made
+     * before anything moves, and a failure removes whatever was added; the
+     * sources are left for the caller to empty.
+     */
+    void distribute(bucket* sources, size_t n) const {
+        size_t added[bucket_count] = {};
+        for (size_t s = 0; s < n; ++s) {
+            for (size_t i = 0; i < sources[s].size; ++i) {
+                ++added[index_of(sources[s].items[i].code)];
+            }
+        }
+        for (size_t j = 0; j < bucket_count; ++j) {
+            if (added[j]) reserve(buckets[j], buckets[j].size + added[j]);
+            added[j] = buckets[j].size;
+        }
+        try {
+            for (size_t s = 0; s < n; ++s) {
+                for (size_t i = 0; i < sources[s].size; ++i) {
+                    item& from = sources[s].items[i];
+                    bucket& to = buckets[index_of(from.code)];
+                    new (to.items + to.size) item(std::move_if_noexcept(from));
+                    ++to.size;
+                }
+            }
+        } catch (...) {
+            for (size_t j = 0; j < bucket_count; ++j) {
+                while (buckets[j].size > added[j]) {
+                    buckets[j].items[--buckets[j].size].~item();
+                }
+            }
+            throw;
+        }
+    }
+
+    /**
+     * @brief make bucket 0 non-empty: take the lowest non-empty bucket,
+     * raise last to its smallest code and spread it over the lower buckets.
+     */
+    void pull() const {
+        if (buckets[0].size) return;
+        size_t i = 1;
+        while (!buckets[i].size) ++i;
+        bucket& b = buckets[i];
+        code_type smallest = b.items[0].code;
+        for (size_t k = 1; k < b.size; ++k) {
+            if (b.items[k].code < smallest) smallest = b.items[k].code;
+        }
+        code_type floor = last;
+        last = smallest;
+        try {
+            distribute(&b, 1);
+        } catch (...) {
+            last = floor;
+            throw;
+        }
+        empty_out(b);
+    }
+
+    item& front() const {
+        pull();
+        return buckets[0].items[buckets[0].size - 1];
+    }
+
+    void copy_from(const radix_heap& other) {
+        for (size_t j = 0; j < bucket_count; ++j) {
+            const bucket& from = other.buckets[j];
+            if (!from.size) continue;
+            bucket& to = buckets[j];
+            to.items = allocate(from.size);
+            to.capacity = from.size;
+            for (; to.size < from.size; ++to.size) {
+                new (to.items + to.size) item(from.items[to.size]);
+            }
+        }
+        last = other.last;
+        _size = other._size;
+    }
+
+    void destroy_all() {
+        for (size_t j = 0; j < bucket_count; ++j) {
+            empty_out(buckets[j]);
+            deallocate(buckets[j].items);
+            buckets[j].items = nullptr;
+            buckets[j].capacity = 0;
+        }
+        _size = 0;
+    }
+
+   public:
+    /**
+     * @brief default constructor
+     */
+    radix_heap() : buckets(), last(0), _size(0) {
+    }
+
+    /**
+     * @brief copy constructor
+     */
+    radix_heap(const radix_heap& other) : buckets(), last(0), _size(0) {
+        try {
+            copy_from(other);
+        } catch (...) {
+            destroy_all();
+            throw;
+        }
+    }
+
+    /**
+     * @brief deconstructor
+     */
+    ~radix_heap() {
+        destroy_all();
+    }
+
+    /**
+     * @brief Assignment operator
+     */
+    radix_heap& operator=(const radix_heap& other) {
+        if (this == &other) return *this;
+        radix_heap copy(other);
+        swap(copy);
+        return *this;
+    }
+
+    void swap(radix_heap& other) {
+        for (size_t j = 0; j < bucket_count; ++j) {
+            std::swap(buckets[j], other.buckets[j]);
+        }
+        std::swap(last, other.last);
+        std::swap(_size, other._size);
+    }
+
+    /**
+     * @brief the value with the smallest key.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& top() const {
+        if (empty()) throw container_is_empty();
+        return front().value;
+    }
+
+    /**
+     * @brief the smallest key.
+     * @throws container_is_empty if empty() returns true
+     */
+    Key top_key() const {
+        if (empty()) throw container_is_empty();
+        pull();
+        return traits::decode(last);
+    }
+
+    /**
+     * @brief push a value under key.
+     * @throws runtime_error if key is below the last key taken
+     */
+    void push(const Key& key, const T& value) {
+        emplace(key, value);
+    }
+
+    /**
+     * @brief push a value under key, moving from value.
+     */
+    void push(const Key& key, T&& value) {
+        emplace(key, std::move(value));
+    }
+
+    /**
+     * @brief push a value constructed in place from args under key.
+     * @throws runtime_error if key is below the last key taken
+     */
+    template <class... Args>
+    void emplace(const Key& key, Args&&... args) {
+        code_type code = traits::encode(key);
+        if (code < last) throw runtime_error();
+        bucket& b = buckets[index_of(code)];
+        if (b.size == b.capacity) {
+            // args may refer into the bucket, so build before it moves
+            item fresh(code, std::forward<Args>(args)...);
+            reserve(b, b.size + 1);
+            new (b.items + b.size) item(std::move(fresh));
+        } else {
+            new (b.items + b.size) item(code, std::forward<Args>(args)...);
+        }
+        ++b.size;
+        ++_size;
+    }
+
+    /**
+     * @brief delete the element with the smallest key.
+     * @throws container_is_empty if empty() returns true
+     */
+    void pop() {
+        if (empty()) throw container_is_empty();
+        front().~item();
+        --buckets[0].size;
+        --_size;
+    }
+
+    /**
+     * @brief remove the element with the smallest key and return its value,
+     * moved out rather than copied (unless T can only be moved by a
+     * throwing constructor).
+     * @throws container_is_empty if empty() returns true
+     */
+    T pop_value() {
+        if (empty()) throw container_is_empty();
+        item& top = front();
+        T value(std::move_if_noexcept(top.value));
+        top.~item();
+        --buckets[0].size;
+        --_size;
+        return value;
+    }
+
+    /**
+     * @brief return the number of elements.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @brief check if the container is empty.
+     */
+    bool empty() const {
+        return _size == 0;
+    }
+
+    /**
+     * @brief move every element of other into this heap in O(m); other is
+     * left empty. Merging into an empty heap just takes other's buckets.
+     * @throws runtime_error if other holds a key below this heap's last key
+     * taken; neither heap changes then
+     */
+    void merge(radix_heap& other) {
+        if (this == &other || other.empty()) return;
+        if (empty()) {
+            swap(other);
+            return;
+        }
+        for (size_t j = 0; j < bucket_count; ++j) {
+            for (size_t i = 0; i < other.buckets[j].size; ++i) {
+                if (other.buckets[j].items[i].code < last) {
+                    throw runtime_error();
+                }
+            }
+        }
+        distribute(other.buckets, bucket_count);
+        for (size_t j = 0; j < bucket_count; ++j) {
+            empty_out(other.buckets[j]);
+        }
+        _size += other._size;
+        other._size = 0;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,324 @@
+#ifndef SJTU_STABLE_HPP
+#define SJTU_STABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "priority_queue.hpp"
+
+namespace sjtu {
+/**
+ * @brief engine tag for priority_queue: Engine with FIFO tie-breaking.
+ * Elements that compare equal leave in the order they were pushed, so a
+ * scheduler gets fairness among equal priorities without wrapping every
+ * element in a struct with its own sequence number.
+ *
+ * Each element is tagged with an insertion sequence number that is only
+ * looked at when Compare finds neither element greater. The tag is 32 bits
+ * when that fits in the padding a pointer-aligned node leaves after T (so
+ * a skew heap node of int stays 24 bytes) and 64 bits otherwise, where
+ * either would cost a full word. 32-bit tags compare modulo 2^32, so ties
+ * keep arrival order as long as the tied elements were pushed fewer than
+ * 2^31 pushes apart.
+ */
+template <class Engine = skew_heap>
+struct stable {};
+
+namespace stable_detail {
+
+constexpr size_t round_up(size_t n, size_t a) {
+    return (n + a - 1) / a * a;
+}
+
+template <class T, class S>
+struct item {
+    T value;
+    S seq;
+
+    template <class... Args>
+    explicit item(S seq, Args&&... args)
+        : value(std::forward<Args>(args)...), seq(seq) {
+    }
+};
+
+template <class T>
+constexpr size_t node_alignment =
+    alignof(T) > alignof(void*) ? alignof(T) : alignof(void*);
+
+template <class T>
+using sequence_t = std::conditional_t<
+    round_up(sizeof(item<T, std::uint32_t>), node_alignment<T>) ==
+        round_up(sizeof(T), node_alignment<T>),
+    std::uint32_t, std::uint64_t>;
+
+/**
+ * @brief Compare on the values, then the earlier tag ranks higher.
+ */
+template <class T, class S, class Compare>
+struct fifo_compare {
+    [[no_unique_address]] Compare cmp;
+
+    static bool later(S a, S b) {
+        if constexpr (sizeof(S) == 4) {
+            return static_cast<std::int32_t>(a - b) > 0;
+        } else {
+            return a > b;
+        }
+    }
+
+    bool operator()(const item<T, S>& a, const item<T, S>& b) const {
+        if (cmp(a.value, b.value)) return true;
+        if (cmp(b.value, a.value)) return false;
+        return later(a.seq, b.seq);
+    }
+};
+
+/**
+ * @brief adapts an input iterator to yield tagged items, numbering them
+ * from a starting tag.
+ */
+template <class It, class T, class S>
+class tagging_iterator {
+   private:
+    It it;
+    S seq;
+
+   public:
+    tagging_iterator(It it, S seq) : it(it), seq(seq) {
+    }
+    item<T, S> operator*() const {
+        return item<T, S>(seq, *it);
+    }
+    tagging_iterator& operator++() {
+        ++it;
+        ++seq;
+        return *this;
+    }
+    bool operator==(const tagging_iterator& rhs) const {
+        return it == rhs.it;
+    }
+    bool operator!=(const tagging_iterator& rhs) const {
+        return it != rhs.it;
+    }
+    auto operator-(const tagging_iterator& rhs) const
+        requires requires(It a, It b) { a - b; }
+    {
+        return it - rhs.it;
+    }
+};
+
+/**
+ * @brief an output iterator that writes the values of the items assigned
+ * to it to out.
+ */
+template <class OutputIt, class T, class S>
+struct value_output {
+    OutputIt out;
+
+    value_output& operator*() {
+        return *this;
+    }
+    value_output& operator++() {
+        ++out;
+        return *this;
+    }
+    value_output& operator=(item<T, S>&& e) {
+        *out = std::move(e.value);
+        return *this;
+    }
+};
+
+}  // namespace stable_detail
+
+template <typename T, class Compare, class Engine>
+class priority_queue<T, Compare, stable<Engine>> {
+   private:
+    typedef stable_detail::sequence_t<T> seq_type;
+    typedef stable_detail::item<T, seq_type> item;
+    typedef stable_detail::fifo_compare<T, seq_type, Compare> item_compare;
+    template <class It>
+    using tagging = stable_detail::tagging_iterator<It, T, seq_type>;
+
+    priority_queue<item, item_compare, Engine> queue;
+    // the tag of the next element pushed
+    seq_type next;
+
+   public:
+    /**
+     * @brief default constructor
+     */
+    priority_queue() : queue(), next(0) {
+    }
+
+    /**
+     * @brief an empty queue ordered by a copy of compare.
+     */
+    explicit priority_queue(const Compare& compare)
+        : queue(item_compare{compare}), next(0) {
+    }
+
+    /**
+     * @brief a queue of the elements of [first, last), tagged in that
+     * order, built in O(n).
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    priority_queue(InputIt first, InputIt last,
+                   const Compare& compare = Compare())
+        : queue(tagging<InputIt>(first, 0), tagging<InputIt>(last, 0),
+                item_compare{compare}),
+          next(static_cast<seq_type>(queue.size())) {
+    }
+
+    /**
+     * @brief a queue of the elements of a container such as sjtu::vector.
+     */
+    template <class Container,
+              class = decltype(std::declval<const Container&>().begin())>
+    explicit priority_queue(const Container& elements,
+                            const Compare& compare = Compare())
+        : priority_queue(elements.begin(), elements.end(), compare) {
+    }
+
+    /**
+     * @brief replace the contents with the elements of [first, last).
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void assign(InputIt first, InputIt last) {
+        queue.assign(tagging<InputIt>(first, 0), tagging<InputIt>(last, 0));
+        next = static_cast<seq_type>(queue.size());
+    }
+
+    /**
+     * @brief replace the contents with the elements of a container.
+     */
+    template <class Container,
+              class = decltype(std::declval<const Container&>().begin())>
+    void assign(const Container& elements) {
+        assign(elements.begin(), elements.end());
+    }
+
+    /**
+     * @brief get the top element; among equal ones, the earliest pushed.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& top() const {
+        return queue.top().value;
+    }
+
+    /**
+     * @brief push new element to the priority queue.
+     */
+    void push(const T& e) {
+        emplace(e);
+    }
+
+    /**
+     * @brief push an element, moving from e.
+     */
+    void push(T&& e) {
+        emplace(std::move(e));
+    }
+
+    /**
+     * @brief push an element constructed in place from args.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        queue.emplace(next, std::forward<Args>(args)...);
+        ++next;
+    }
+
+    /**
+     * @brief push the elements of [first, last) at once, tagged in that
+     * order; see the engine's push_range.
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    void push_range(InputIt first, InputIt last) {
+        size_t before = queue.size();
+        queue.push_range(tagging<InputIt>(first, next),
+                         tagging<InputIt>(last, next));
+        next += static_cast<seq_type>(queue.size() - before);
+    }
+
+    /**
+     * @brief push the elements of a container such as sjtu::vector.
+     */
+    template <class Container,
+              class = decltype(std::declval<const Container&>().begin())>
+    void push_range(const Container& elements) {
+        push_range(elements.begin(), elements.end());
+    }
+
+    /**
+     * @brief delete the top element.
+     * @throws container_is_empty if empty() returns true
+     */
+    void pop() {
+        queue.pop();
+    }
+
+    /**
+     * @brief remove the top element and return it, moved out.
+     * @throws container_is_empty if empty() returns true
+     */
+    T pop_value() {
+        return queue.pop_value().value;
+    }
+
+    /**
+     * @brief move the best min(k, size()) elements to out, best first, and
+     * remove them; see the engine's pop_k.
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt pop_k(size_t k, OutputIt out) {
+        stable_detail::value_output<OutputIt, T, seq_type> values{out};
+        return queue.pop_k(k, values).out;
+    }
+
+    /**
+     * @brief move every element to out, best first, leaving the queue
+     * empty.
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt drain_sorted(OutputIt out) {
+        return pop_k(size(), out);
+    }
+
+    size_t size() const {
+        return queue.size();
+    }
+
+    bool empty() const {
+        return queue.empty();
+    }
+
+    /**
+     * @brief a copy of the comparator that orders the values.
+     */
+    Compare value_comp() const {
+        return queue.value_comp().cmp;
+    }
+
+    /**
+     * @brief merge another priority_queue into this one; other is left
+     * empty. Ties between the two queues' elements follow their tags.
+     */
+    void merge(priority_queue& other) {
+        queue.merge(other.queue);
+        if (stable_detail::fifo_compare<T, seq_type, Compare>::later(
+                other.next, next)) {
+            next = other.next;
+        }
+    }
+};
+
+}  // namespace sjtu
+
+#endif
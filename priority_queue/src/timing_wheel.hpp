@@ -0,0 +1,437 @@
+#ifndef SJTU_TIMING_WHEEL_HPP
+#define SJTU_TIMING_WHEEL_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "exceptions.hpp"
+#include "node_pool.hpp"
+
+namespace sjtu {
+/**
+ * @brief timers keyed by a 64-bit tick, for workloads where most timers are
+ * cancelled before they fire: schedule and cancel are O(1), and advance()
+ * fires whatever has come due in one batch.
+ *
+ * This is a hierarchical timing wheel of 11 levels of 64 slots. A timer
+ * due at d sits on the level of the highest 6-bit digit in which d differs
+ * from now(), in the slot named by that digit, so level 0 holds the ticks
+ * of the current 64-tick block one slot per tick, level 1 the rest of the
+ * current 4096-tick block 64 ticks per slot, and so on. As time reaches a
+ * slot on a higher level, its timers cascade down to lower ones; a timer
+ * cascades at most once per level. Each level keeps a bitmap of its
+ * non-empty slots, so advancing over empty stretches costs nothing.
+ *
+ * Timers due at the same tick fire in Compare order, greatest first, as
+ * they would leave a priority_queue; timers scheduled in the past fire on
+ * the next advance, earliest first.
+ *
+ * **Exception Safety**: if `Compare` throws while a tick's timers are
+ * ordered, advance() throws runtime_error and those timers stay scheduled,
+ * due on the next advance. The same happens to the timers not yet written
+ * if writing to the output throws.
+ */
+template <typename T, class Compare = std::less<T>>
+class timing_wheel {
+   private:
+    static const size_t slot_bits = 6;
+    static const size_t slots_per_level = size_t(1) << slot_bits;
+    static const size_t levels = (64 + slot_bits - 1) / slot_bits;
+
+    struct Node {
+        T data;
+        std::uint64_t deadline;
+        Node* prev;
+        Node* next;
+
+        template <class... Args>
+        explicit Node(std::uint64_t deadline, Args&&... args)
+            : data(std::forward<Args>(args)...),
+              deadline(deadline),
+              prev(nullptr),
+              next(nullptr) {
+        }
+    };
+
+    typedef node_pool<Node> pool_type;
+
+    Node* slots[levels][slots_per_level];
+    std::uint64_t occupied[levels];
+    // timers due at or before now, waiting for the next advance
+    Node* due;
+    std::uint64_t current;
+    size_t _size;
+    pool_type* pool;
+    // where a batch is put in firing order; kept between advances
+    Node** scratch;
+    size_t scratch_capacity;
+    [[no_unique_address]] Compare cmp;
+
+    pool_type* node_source() {
+        if (!pool) pool = pool_type::create();
+        return pool_type::find(pool);
+    }
+
+    template <class... Args>
+    Node* create_node(Args&&... args) {
+        pool_type* source = node_source();
+        void* memory = source->allocate();
+        try {
+            return new (memory) Node(std::forward<Args>(args)...);
+        } catch (...) {
+            source->deallocate(memory);
+            throw;
+        }
+    }
+
+    void destroy_node(Node* node) {
+        node->~Node();
+        pool_type::find(pool)->deallocate(node);
+    }
+
+    static void link(Node*& head, Node* node) {
+        node->prev = nullptr;
+        node->next = head;
+        if (head) head->prev = node;
+        head = node;
+    }
+
+    static void unlink(Node*& head, Node* node) {
+        if (node->prev) {
+            node->prev->next = node->next;
+        } else {
+            head = node->next;
+        }
+        if (node->next) node->next->prev = node->prev;
+    }
+
+    size_t level_of(std::uint64_t deadline) const {
+        return (std::bit_width(deadline ^ current) - 1) / slot_bits;
+    }
+
+    static size_t slot_of(std::uint64_t deadline, size_t level) {
+        return (deadline >> (level * slot_bits)) & (slots_per_level - 1);
+    }
+
+    /**
+     * @brief the first tick covered by slot s of a level, in the block
+     * now() is in.
+     */
+    std::uint64_t slot_start(size_t level, size_t s) const {
+        size_t shift = level * slot_bits;
+        size_t block = shift + slot_bits;
+        std::uint64_t high = block < 64 ? current >> block << block : 0;
+        return high | (std::uint64_t(s) << shift);
+    }
+
+    /**
+     * @brief file a node under its deadline, relative to now().
+     */
+    void place(Node* node) {
+        if (node->deadline <= current) {
+            link(due, node);
+            return;
+        }
+        size_t level = level_of(node->deadline);
+        size_t s = slot_of(node->deadline, level);
+        link(slots[level][s], node);
+        occupied[level] |= std::uint64_t(1) << s;
+    }
+
+    /**
+     * @brief take a node off the list it is filed under.
+     */
+    void detach(Node* node) {
+        if (node->deadline <= current) {
+            unlink(due, node);
+            return;
+        }
+        size_t level = level_of(node->deadline);
+        size_t s = slot_of(node->deadline, level);
+        unlink(slots[level][s], node);
+        if (!slots[level][s]) occupied[level] &= ~(std::uint64_t(1) << s);
+    }
+
+    bool fires_before(const Node* a, const Node* b) const {
+        if (a->deadline != b->deadline) return a->deadline < b->deadline;
+        return cmp(b->data, a->data);
+    }
+
+    void sift(Node** a, size_t i, size_t n) const {
+        Node* moved = a[i];
+        while (2 * i + 1 < n) {
+            size_t child = 2 * i + 1;
+            if (child + 1 < n && fires_before(a[child], a[child + 1])) {
+                ++child;
+            }
+            if (!fires_before(moved, a[child])) break;
+            a[i] = a[child];
+            i = child;
+        }
+        a[i] = moved;
+    }
+
+    /**
+     * @brief heap sort a[0, n) into firing order. Only the array of
+     * pointers is written.
+     */
+    void sort_batch(Node** a, size_t n) const {
+        for (size_t start = n / 2; start-- > 0;) sift(a, start, n);
+        for (size_t end = n; end-- > 1;) {
+            std::swap(a[0], a[end]);
+            sift(a, 0, end);
+        }
+    }
+
+    void reserve_scratch(size_t n) {
+        if (n <= scratch_capacity) return;
+        size_t grown = scratch_capacity < 16 ? 16 : scratch_capacity * 2;
+        if (grown < n) grown = n;
+        Node** fresh = new Node*[grown];
+        delete[] scratch;
+        scratch = fresh;
+        scratch_capacity = grown;
+    }
+
+    /**
+     * @brief write the timers of a detached list, all due, to out in firing
+     * order and free them. Whatever is not written is filed as due again.
+     */
+    template <class OutputIt>
+    void fire(Node* batch, OutputIt& out) {
+        size_t n = 0;
+        for (Node* node = batch; node; node = node->next) ++n;
+        bool sorting = false;
+        try {
+            reserve_scratch(n);
+            n = 0;
+            for (Node* node = batch; node; node = node->next) {
+                scratch[n++] = node;
+            }
+            sorting = true;
+            sort_batch(scratch, n);
+        } catch (...) {
+            while (batch) {
+                Node* next = batch->next;
+                link(due, batch);
+                batch = next;
+            }
+            if (sorting) throw runtime_error();
+            throw;
+        }
+        size_t i = 0;
+        try {
+            for (; i < n; ++i) {
+                *out = std::move(scratch[i]->data);
+                ++out;
+                destroy_node(scratch[i]);
+                --_size;
+            }
+        } catch (...) {
+            for (; i < n; ++i) link(due, scratch[i]);
+            throw;
+        }
+    }
+
+    void destroy_list(Node*& head, bool recycle) {
+        while (head) {
+            Node* next = head->next;
+            if (recycle) {
+                destroy_node(head);
+            } else {
+                head->~Node();
+            }
+            head = next;
+        }
+    }
+
+    void release() {
+        delete[] scratch;
+        scratch = nullptr;
+        scratch_capacity = 0;
+        if (!pool) return;
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            destroy_list(due, false);
+            for (size_t level = 0; level < levels; ++level) {
+                for (size_t s = 0; s < slots_per_level; ++s) {
+                    destroy_list(slots[level][s], false);
+                }
+            }
+        }
+        pool_type::release(pool);
+        pool = nullptr;
+    }
+
+   public:
+    /**
+     * @brief refers to one pending timer; valid until it fires or is
+     * cancelled. Default-constructed handles refer to nothing.
+     */
+    class handle {
+       private:
+        Node* node;
+        friend class timing_wheel;
+        explicit handle(Node* node) : node(node) {
+        }
+
+       public:
+        handle() : node(nullptr) {
+        }
+        bool operator==(const handle& rhs) const {
+            return node == rhs.node;
+        }
+        bool operator!=(const handle& rhs) const {
+            return node != rhs.node;
+        }
+    };
+
+    /**
+     * @brief an empty wheel whose clock starts at tick start.
+     */
+    explicit timing_wheel(std::uint64_t start = 0,
+                          const Compare& compare = Compare())
+        : slots(),
+          occupied(),
+          due(nullptr),
+          current(start),
+          _size(0),
+          pool(nullptr),
+          scratch(nullptr),
+          scratch_capacity(0),
+          cmp(compare) {
+    }
+
+    // handles point into a wheel, so it is not copied
+    timing_wheel(const timing_wheel&) = delete;
+    timing_wheel& operator=(const timing_wheel&) = delete;
+
+    /**
+     * @brief deconstructor
+     */
+    ~timing_wheel() {
+        release();
+    }
+
+    /**
+     * @brief schedule a timer constructed from args to fire at deadline.
+     * O(1).
+     * @return a handle to cancel or reschedule it with
+     */
+    template <class... Args>
+    handle schedule(std::uint64_t deadline, Args&&... args) {
+        Node* node = create_node(deadline, std::forward<Args>(args)...);
+        place(node);
+        ++_size;
+        return handle(node);
+    }
+
+    /**
+     * @brief remove a pending timer without firing it. O(1).
+     */
+    void cancel(handle h) {
+        detach(h.node);
+        destroy_node(h.node);
+        --_size;
+    }
+
+    /**
+     * @brief move a pending timer to a new deadline. O(1); the handle stays
+     * valid.
+     */
+    void reschedule(handle h, std::uint64_t deadline) {
+        detach(h.node);
+        h.node->deadline = deadline;
+        place(h.node);
+    }
+
+    /**
+     * @brief the payload of a pending timer.
+     */
+    const T& get(handle h) const {
+        return h.node->data;
+    }
+
+    /**
+     * @brief when a pending timer is due.
+     */
+    std::uint64_t deadline(handle h) const {
+        return h.node->deadline;
+    }
+
+    /**
+     * @brief move the clock to tick to and write every timer due by then to
+     * out, in order of deadline and, within a tick, in Compare order.
+     * Time never goes back; an earlier tick only fires what is overdue.
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt advance(std::uint64_t to, OutputIt out) {
+        while (true) {
+            if (due) {
+                Node* batch = due;
+                due = nullptr;
+                fire(batch, out);
+            }
+            size_t level = 0;
+            while (level < levels && !occupied[level]) ++level;
+            if (level == levels) break;
+            size_t s = std::countr_zero(occupied[level]);
+            std::uint64_t start = slot_start(level, s);
+            if (start > to) break;
+            Node* batch = slots[level][s];
+            slots[level][s] = nullptr;
+            occupied[level] &= ~(std::uint64_t(1) << s);
+            current = start;
+            if (level == 0) {
+                fire(batch, out);
+            } else {
+                // every timer here is due within the slot: one level down
+                // at least, or due now
+                while (batch) {
+                    Node* next = batch->next;
+                    place(batch);
+                    batch = next;
+                }
+            }
+        }
+        if (to > current) current = to;
+        return out;
+    }
+
+    /**
+     * @brief the current tick: every timer due by it has fired.
+     */
+    std::uint64_t now() const {
+        return current;
+    }
+
+    /**
+     * @brief a copy of the comparator that orders timers within a tick.
+     */
+    Compare value_comp() const {
+        return cmp;
+    }
+
+    /**
+     * @brief return the number of pending timers.
+     */
+    size_t size() const {
+        return _size;
+    }
+
+    /**
+     * @brief check if no timer is pending.
+     */
+    bool empty() const {
+        return _size == 0;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef SJTU_TOP_K_HPP
+#define SJTU_TOP_K_HPP
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include "dary_heap.hpp"
+#include "exceptions.hpp"
+
+namespace sjtu {
+/**
+ * @brief keeps the k greatest elements (by Compare, as priority_queue's top
+ * is the greatest) of a stream of any length.
+ *
+ * The kept elements are a priority_queue on the 4-ary engine, ordered with
+ * the least of them on top, whose storage for k elements is reserved up
+ * front; nothing is allocated after construction. A candidate that cannot
+ * enter costs one comparison with that least element; one that can
+ * replaces it in place and sifts down. drain() hands the elements out best
+ * first by sorting the array in place.
+ *
+ * **Exception Safety**: if `Compare` throws, runtime_error is thrown and
+ * the container keeps exactly the elements it had (drain may leave them in
+ * a different internal order).
+ */
+template <typename T, class Compare = std::less<T>>
+class top_k {
+   private:
+    // orders the heap least first, so its top is the one to evict
+    struct reversed {
+        [[no_unique_address]] Compare cmp;
+
+        bool operator()(const T& a, const T& b) const {
+            return cmp(b, a);
+        }
+    };
+
+    typedef priority_queue<T, reversed, dary_heap<4>> heap_type;
+
+    heap_type kept;
+    size_t k;
+
+    template <class U>
+    bool offer(U&& e) {
+        if (k == 0) return false;
+        if (kept.size() < k) {
+            kept.push(std::forward<U>(e));
+            return true;
+        }
+        bool enters;
+        try {
+            enters = kept.cmp(e, kept.top());
+        } catch (...) {
+            throw runtime_error();
+        }
+        if (!enters) return false;
+        kept.replace_top(std::forward<U>(e));
+        return true;
+    }
+
+   public:
+    /**
+     * @brief an empty container that keeps at most k elements.
+     */
+    explicit top_k(size_t k, const Compare& compare = Compare())
+        : kept(reversed{compare}), k(k) {
+        kept.reserve(k);
+    }
+
+    /**
+     * @brief copy constructor
+     */
+    top_k(const top_k& other) : kept(other.kept.cmp), k(other.k) {
+        kept.copy_from(other.kept, k);
+    }
+
+    /**
+     * @brief Assignment operator
+     */
+    top_k& operator=(const top_k& other) {
+        if (this == &other) return *this;
+        top_k copy(other);
+        kept.cmp = other.kept.cmp;
+        kept.swap_storage(copy.kept);
+        k = copy.k;
+        return *this;
+    }
+
+    /**
+     * @brief offer a candidate.
+     * @return whether it was kept
+     */
+    bool push(const T& e) {
+        return offer(e);
+    }
+
+    /**
+     * @brief offer a candidate, moving from it if it is kept.
+     */
+    bool push(T&& e) {
+        return offer(std::move(e));
+    }
+
+    /**
+     * @brief the least kept element: a candidate must compare greater to
+     * enter once the container is full.
+     * @throws container_is_empty if empty() returns true
+     */
+    const T& worst() const {
+        return kept.top();
+    }
+
+    /**
+     * @brief write the kept elements to out, greatest first, and empty the
+     * container. O(k log k) and allocation free.
+     * @return the advanced output iterator
+     */
+    template <class OutputIt>
+    OutputIt drain(OutputIt out) {
+        // the heap's worst is the greatest
+        return kept.drain_reversed(out);
+    }
+
+    /**
+     * @brief remove every element, keeping the storage.
+     */
+    void clear() {
+        kept.clear();
+    }
+
+    /**
+     * @brief return the number of elements kept.
+     */
+    size_t size() const {
+        return kept.size();
+    }
+
+    /**
+     * @brief the most elements it will keep.
+     */
+    size_t capacity() const {
+        return k;
+    }
+
+    bool empty() const {
+        return kept.empty();
+    }
+
+    bool full() const {
+        return kept.size() == k;
+    }
+};
+
+}  // namespace sjtu
+
+#endif
@@ -0,0 +1,56 @@
+#include <cstdint>
+#include <iostream>
+
+#include "vector.hpp"
+
+template <class Vec>
+bool aligned_to(const Vec &v, size_t align) {
+    return reinterpret_cast<std::uintptr_t>(v.data()) % align == 0;
+}
+
+void test_aligned() {
+    sjtu::vector<float, 64> a;
+    bool ok = true;
+    for (int i = 0; i < 1000; i++) {
+        a.push_back(i * 0.5f);
+        ok = ok && aligned_to(a, 64);
+    }
+    sjtu::vector<float, 64> b(a);
+    sjtu::vector<float, 64> c;
+    c = a;
+    ok = ok && aligned_to(b, 64) && aligned_to(c, 64);
+    double sum = 0;
+    for (size_t i = 0; i < c.size(); i++) sum += c[i];
+    std::cout << "64-byte aligned: " << ok << " sum: " << sum << std::endl;
+
+    sjtu::vector<char, 4096> page;
+    ok = true;
+    for (int i = 0; i < 10000; i++) {
+        page.push_back('a' + i % 26);
+        ok = ok && aligned_to(page, 4096);
+    }
+    std::cout << "page aligned: " << ok << " back: " << page.back()
+              << std::endl;
+}
+
+void test_padded() {
+    sjtu::padded_vector<long> slots;
+    for (int i = 0; i < 16; i++) slots.push_back(i);
+    bool ok = sizeof(slots[0]) == sjtu::cache_line_size;
+    for (size_t i = 0; i < slots.size(); i++) {
+        ok = ok && reinterpret_cast<std::uintptr_t>(&slots[i].value) %
+                           sjtu::cache_line_size ==
+                       0;
+        slots[i].value += 100;
+    }
+    long total = 0;
+    for (size_t i = 0; i < slots.size(); i++) total += slots[i];
+    std::cout << "one slot per line: " << ok << " total: " << total
+              << std::endl;
+}
+
+int main() {
+    test_aligned();
+    test_padded();
+    return 0;
+}
@@ -0,0 +1,55 @@
+#define SJTU_VECTOR_STATS
+#include <iostream>
+#include <list>
+#include <ranges>
+#include <sstream>
+#include <iterator>
+
+#include "vector.hpp"
+
+template <class T>
+void dump(const char *name, const sjtu::vector<T> &v) {
+    std::cout << name << ":";
+    for (size_t i = 0; i < v.size(); i++) std::cout << ' ' << v[i];
+    sjtu::vector_stats s = v.stats();
+    std::cout << " | size " << v.size() << ", capacity "
+              << s.peak_capacity_bytes / sizeof(T) << ", reallocations "
+              << s.reallocations << std::endl;
+}
+
+int main() {
+    sjtu::vector<int> a{3, 1, 4, 1, 5, 9, 2, 6};
+    dump("initializer_list", a);
+
+    sjtu::vector<int> b(5, 7);
+    dump("count and value", b);
+
+    sjtu::vector<long> c(4);
+    dump("count", c);
+
+    int raw[] = {10, 20, 30, 40, 50};
+    sjtu::vector<int> d(raw, raw + 5);
+    dump("pointer range", d);
+
+    sjtu::vector<int> e(a.begin() + 2, a.end());
+    dump("sjtu iterators", e);
+
+    std::list<int> list = {1, 2, 3, 4, 5, 6, 7};
+    sjtu::vector<int> f(list.begin(), list.end());
+    dump("forward iterators", f);
+
+    std::istringstream in("8 6 7 5 3 0 9");
+    sjtu::vector<int> g((std::istream_iterator<int>(in)),
+                        std::istream_iterator<int>());
+    dump("input iterators", g);
+
+    sjtu::vector<int> h(sjtu::from_range, std::views::iota(0, 10));
+    dump("sized range", h);
+
+    sjtu::vector<int> i(sjtu::from_range,
+                        std::views::iota(0, 30) | std::views::filter([](int x) {
+                            return x % 3 == 0;
+                        }));
+    dump("filtered range", i);
+    return 0;
+}
@@ -0,0 +1,44 @@
+#define SJTU_VECTOR_STATS
+#include <iostream>
+
+#include "vector.hpp"
+
+void print(const char *name, const sjtu::vector_stats &s) {
+    std::cout << name << ": reallocations " << s.reallocations
+              << ", bytes relocated " << s.bytes_relocated << ", copies "
+              << s.copy_constructions << ", moves " << s.move_constructions
+              << ", peak capacity " << s.peak_capacity_bytes << ", slack "
+              << s.slack_bytes << std::endl;
+}
+
+struct Payload {
+    int data[4];
+    Payload(int v) : data{v, v, v, v} {
+    }
+};
+
+int main() {
+    sjtu::vector<int> a;
+    for (int i = 0; i < 1000; i++) a.push_back(i);
+    print("push_back x1000", a.stats());
+
+    a.insert(0, -1);
+    a.erase(10);
+    a.pop_back();
+    print("after insert/erase/pop_back", a.stats());
+
+    sjtu::vector<int> b(a);
+    print("copy", b.stats());
+
+    {
+        sjtu::vector<Payload> payloads;
+        for (int i = 0; i < 5; i++) payloads.push_back(Payload(i));
+        print("payloads", payloads.stats());
+    }
+
+    print("global", sjtu::vector_global_stats());
+    sjtu::reset_vector_global_stats();
+    b.clear();
+    print("global after reset", sjtu::vector_global_stats());
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <iostream>
+
+#include "vector.hpp"
+
+int copies_left = -1;  // copies allowed before Fragile throws, -1 = no limit
+int live = 0;
+
+// move may throw, so the vector has to relocate it by copy
+struct Fragile {
+    int value;
+    Fragile(int v) : value(v) {
+        ++live;
+    }
+    Fragile(const Fragile &other) : value(other.value) {
+        if (copies_left == 0) throw sjtu::runtime_error();
+        if (copies_left > 0) --copies_left;
+        ++live;
+    }
+    Fragile(Fragile &&other) : value(other.value) {
+        other.value = -1;
+        ++live;
+    }
+    Fragile &operator=(const Fragile &other) {
+        value = other.value;
+        return *this;
+    }
+    ~Fragile() {
+        --live;
+    }
+};
+
+int moves = 0;
+
+struct Movable {
+    int value;
+    Movable(int v) : value(v) {
+    }
+    Movable(const Movable &other) : value(other.value) {
+    }
+    Movable(Movable &&other) noexcept : value(other.value) {
+        ++moves;
+    }
+    Movable &operator=(const Movable &other) = default;
+    Movable &operator=(Movable &&other) noexcept = default;
+};
+
+void dump(const sjtu::vector<Fragile> &v) {
+    for (size_t i = 0; i < v.size(); i++) std::cout << v[i].value << ' ';
+    std::cout << "(size " << v.size() << ")" << std::endl;
+}
+
+void test_push_back_rollback() {
+    sjtu::vector<Fragile> v;
+    for (int i = 0; i < 8; i++) v.push_back(Fragile(i));
+    // v is full: growing copies 8 elements, the 5th copy throws
+    copies_left = 5;
+    try {
+        v.push_back(Fragile(8));
+        std::cout << "no exception" << std::endl;
+    } catch (sjtu::runtime_error &) {
+        std::cout << "push_back threw, vector unchanged: ";
+    }
+    copies_left = -1;
+    dump(v);
+}
+
+void test_insert_rollback() {
+    sjtu::vector<Fragile> v;
+    for (int i = 0; i < 6; i++) v.push_back(Fragile(i));
+    copies_left = 3;
+    try {
+        v.insert(2, Fragile(100));
+        std::cout << "no exception" << std::endl;
+    } catch (sjtu::runtime_error &) {
+        std::cout << "insert threw, vector unchanged: ";
+    }
+    copies_left = -1;
+    dump(v);
+    v.insert(2, Fragile(100));
+    v.insert(v.begin(), v[3]);
+    dump(v);
+}
+
+void test_nothrow_move() {
+    sjtu::vector<Movable> v;
+    for (int i = 0; i < 1024; i++) v.push_back(Movable(i));
+    std::cout << "relocated by move: " << moves << std::endl;
+    v.push_back(v[0]);
+    v.insert(1, v[1000]);
+    std::cout << v[1024].value << ' ' << v[1].value << ' ' << v[2].value
+              << std::endl;
+}
+
+int main() {
+    test_push_back_rollback();
+    test_insert_rollback();
+    std::cout << "live objects: " << live << std::endl;
+    test_nothrow_move();
+    return 0;
+}
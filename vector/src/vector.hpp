@@ -6,17 +6,198 @@
 #include <climits>
 #include <cstddef>
 #include <cstring>
+#include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+#ifdef SJTU_VECTOR_STATS
+#include <atomic>
+#endif
 
 #include "exceptions.hpp"
 
 namespace sjtu {
+/**
+ * size of a cache line on the targets we care about.
+ */
+constexpr size_t cache_line_size = 64;
+
+/**
+ * allocation and relocation counters of sjtu::vector.
+ * they are only collected when SJTU_VECTOR_STATS is defined before this
+ * header is included; otherwise the bookkeeping compiles to nothing and every
+ * field reads 0.
+ */
+struct vector_stats {
+    // times the storage was grown
+    size_t reallocations;
+    // bytes of elements carried over to a grown storage
+    size_t bytes_relocated;
+    // elements constructed by copy / by move
+    size_t copy_constructions;
+    size_t move_constructions;
+    // largest capacity seen, in bytes (globally: of any single vector)
+    size_t peak_capacity_bytes;
+    // capacity not holding an element, in bytes (globally: of live vectors)
+    size_t slack_bytes;
+};
+
+#ifdef SJTU_VECTOR_STATS
+namespace vector_detail {
+
+struct global_counters {
+    std::atomic<size_t> reallocations{0};
+    std::atomic<size_t> bytes_relocated{0};
+    std::atomic<size_t> copy_constructions{0};
+    std::atomic<size_t> move_constructions{0};
+    std::atomic<size_t> peak_capacity_bytes{0};
+    std::atomic<size_t> slack_bytes{0};
+};
+
+inline global_counters &globals() {
+    static global_counters counters;
+    return counters;
+}
+
+/**
+ * per-instance counters; every update is mirrored into globals().
+ */
+class recorder {
+   private:
+    vector_stats local;
+
+   public:
+    recorder() : local() {
+    }
+    // a copy starts a history of its own
+    recorder(const recorder &) : local() {
+    }
+    recorder &operator=(const recorder &) {
+        return *this;
+    }
+    ~recorder() {
+        globals().slack_bytes.fetch_sub(local.slack_bytes,
+                                        std::memory_order_relaxed);
+    }
+
+    void copied(size_t n) {
+        local.copy_constructions += n;
+        globals().copy_constructions.fetch_add(n, std::memory_order_relaxed);
+    }
+    void moved(size_t n) {
+        local.move_constructions += n;
+        globals().move_constructions.fetch_add(n, std::memory_order_relaxed);
+    }
+    void relocated(size_t bytes) {
+        ++local.reallocations;
+        local.bytes_relocated += bytes;
+        globals().reallocations.fetch_add(1, std::memory_order_relaxed);
+        globals().bytes_relocated.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void reshaped(size_t capacity_bytes, size_t size_bytes) {
+        if (capacity_bytes > local.peak_capacity_bytes) {
+            local.peak_capacity_bytes = capacity_bytes;
+            size_t peak = globals().peak_capacity_bytes.load(
+                std::memory_order_relaxed);
+            while (capacity_bytes > peak &&
+                   !globals().peak_capacity_bytes.compare_exchange_weak(
+                       peak, capacity_bytes, std::memory_order_relaxed)) {
+            }
+        }
+        size_t slack = capacity_bytes - size_bytes;
+        globals().slack_bytes.fetch_add(slack - local.slack_bytes,
+                                        std::memory_order_relaxed);
+        local.slack_bytes = slack;
+    }
+    vector_stats stats() const {
+        return local;
+    }
+};
+
+}  // namespace vector_detail
+
+/**
+ * counters summed over every sjtu::vector in the program.
+ */
+inline vector_stats vector_global_stats() {
+    vector_detail::global_counters &g = vector_detail::globals();
+    vector_stats s;
+    s.reallocations = g.reallocations.load(std::memory_order_relaxed);
+    s.bytes_relocated = g.bytes_relocated.load(std::memory_order_relaxed);
+    s.copy_constructions = g.copy_constructions.load(std::memory_order_relaxed);
+    s.move_constructions = g.move_constructions.load(std::memory_order_relaxed);
+    s.peak_capacity_bytes =
+        g.peak_capacity_bytes.load(std::memory_order_relaxed);
+    s.slack_bytes = g.slack_bytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+/**
+ * zero the global event counters. slack_bytes describes the live vectors and
+ * is kept.
+ */
+inline void reset_vector_global_stats() {
+    vector_detail::global_counters &g = vector_detail::globals();
+    g.reallocations.store(0, std::memory_order_relaxed);
+    g.bytes_relocated.store(0, std::memory_order_relaxed);
+    g.copy_constructions.store(0, std::memory_order_relaxed);
+    g.move_constructions.store(0, std::memory_order_relaxed);
+    g.peak_capacity_bytes.store(0, std::memory_order_relaxed);
+}
+#else
+namespace vector_detail {
+
+class recorder {
+   public:
+    void copied(size_t) {
+    }
+    void moved(size_t) {
+    }
+    void relocated(size_t) {
+    }
+    void reshaped(size_t, size_t) {
+    }
+    vector_stats stats() const {
+        return vector_stats();
+    }
+};
+
+}  // namespace vector_detail
+
+inline vector_stats vector_global_stats() {
+    return vector_stats();
+}
+
+inline void reset_vector_global_stats() {
+}
+#endif
+
+/**
+ * tag selecting the range constructor, like std::from_range in C++23.
+ */
+struct from_range_t {
+    explicit from_range_t() = default;
+};
+inline constexpr from_range_t from_range{};
+
 /**
  * a data container like std::vector
  * store data in a successive memory and support random access.
+ * Align is the alignment of the storage in bytes. it defaults to alignof(T);
+ * pass 32 or 64 to keep SIMD loads inside a cache line, or 4096 for
+ * page-aligned buffers.
  */
-template <typename T>
+template <typename T, size_t Align = alignof(T)>
 class vector {
+    static_assert((Align & (Align - 1)) == 0,
+                  "vector alignment must be a power of two");
+    static_assert(Align >= alignof(T),
+                  "vector alignment must not be weaker than alignof(T)");
+
    public:
     /**
      * TODO
@@ -52,11 +233,11 @@ class vector {
          * TODO add data members
          *   just add whatever you want.
          */
-        vector<T> *vec;
+        vector *vec;
         size_t index;
 
        public:
-        iterator(vector<T> *v, size_t idx) : vec(v), index(idx) {
+        iterator(vector *v, size_t idx) : vec(v), index(idx) {
         }
 
         /**
@@ -165,11 +346,11 @@ class vector {
 
        private:
         /*TODO*/
-        const vector<T> *vec;
+        const vector *vec;
         size_t index;
 
        public:
-        const_iterator(const vector<T> *v, size_t idx) : vec(v), index(idx) {
+        const_iterator(const vector *v, size_t idx) : vec(v), index(idx) {
         }
 
         /**
@@ -270,13 +451,70 @@ class vector {
      */
     vector() : capacity(0), length(0), container(nullptr) {
     }
+    /**
+     * n copies of value, in a single allocation of exactly n elements.
+     */
+    explicit vector(size_t n, const T &value = T())
+        : capacity(0), length(0), container(nullptr) {
+        reserve_exact(n);
+        try {
+            for (; length < n; ++length) {
+                new (container + length) T(value);
+            }
+        } catch (...) {
+            fail();
+            throw;
+        }
+        telemetry.copied(n);
+        note_shape();
+    }
+    vector(std::initializer_list<T> init)
+        : capacity(0), length(0), container(nullptr) {
+        construct_from(init.begin(), init.size());
+    }
+    /**
+     * the elements of [first, last). when the distance is known up front
+     * (the iterators can be subtracted, or at least walked twice) storage
+     * is allocated exactly once; single-pass iterators fall back to
+     * push_back.
+     */
+    template <class InputIt,
+              class = std::enable_if_t<!std::is_integral_v<InputIt>>>
+    vector(InputIt first, InputIt last)
+        : capacity(0), length(0), container(nullptr) {
+        if constexpr (requires { static_cast<size_t>(last - first); }) {
+            construct_from(first, static_cast<size_t>(last - first));
+        } else if constexpr (std::forward_iterator<InputIt>) {
+            construct_from(first, std::ranges::distance(first, last));
+        } else {
+            append_each(first, last);
+        }
+    }
+    /**
+     * the elements of a C++20 range, e.g. vector<int>(from_range, view).
+     */
+    template <class Range>
+    vector(from_range_t, Range &&range)
+        : capacity(0), length(0), container(nullptr) {
+        if constexpr (std::ranges::sized_range<Range>) {
+            construct_from(std::ranges::begin(range),
+                           static_cast<size_t>(std::ranges::size(range)));
+        } else if constexpr (std::ranges::forward_range<Range>) {
+            construct_from(std::ranges::begin(range),
+                           static_cast<size_t>(std::ranges::distance(range)));
+        } else {
+            append_each(std::ranges::begin(range), std::ranges::end(range));
+        }
+    }
     vector(const vector &other) {
         capacity = other.capacity;
         length = other.length;
-        container = static_cast<T *>(operator new[](capacity * sizeof(T)));
+        container = allocate(capacity);
         for (size_t i = 0; i < length; ++i) {
             new (container + i) T(other.container[i]);
         }
+        telemetry.copied(length);
+        note_shape();
     }
     /**
      * TODO Destructor
@@ -294,10 +532,12 @@ class vector {
         clear();
         capacity = other.capacity;
         length = other.length;
-        container = static_cast<T *>(operator new[](capacity * sizeof(T)));
+        container = allocate(capacity);
         for (size_t i = 0; i < length; ++i) {
             new (container + i) T(other.container[i]);
         }
+        telemetry.copied(length);
+        note_shape();
         return *this;
     }
     /**
@@ -354,6 +594,16 @@ class vector {
         }
         return this->at(length - 1);
     }
+    /**
+     * returns a pointer to the underlying contiguous storage.
+     * the pointer is invalidated by any operation that reallocates.
+     */
+    T *data() {
+        return container;
+    }
+    const T *data() const {
+        return container;
+    }
     /**
      * returns an iterator to the beginning.
      */
@@ -385,6 +635,13 @@ class vector {
         if (length == 0) return true;
         return false;
     }
+    /**
+     * counters of this vector; all zero unless SJTU_VECTOR_STATS is defined.
+     * see vector_global_stats() for the program-wide sums.
+     */
+    vector_stats stats() const {
+        return telemetry.stats();
+    }
     /**
      * returns the number of elements
      */
@@ -398,30 +655,20 @@ class vector {
         for (size_t i = 0; i < length; ++i) {
             container[i].~T();
         }
-        operator delete[](container);
+        deallocate(container);
         container = nullptr;
         capacity = 0;
         length = 0;
+        note_shape();
     }
     /**
      * inserts value before pos
      * returns an iterator pointing to the inserted value.
      */
     iterator insert(iterator pos, const T &value) {
-        if (length == capacity) {
-            size_t offset = pos - begin();
-            double_space();
-            pos = begin() + offset;
-        }
-
-        for (size_t i = length; i > (pos - begin()); --i) {
-            new (container + i) T(std::move(container[i - 1]));
-            container[i - 1].~T();
-        }
-
-        new (container + (pos - begin())) T(value);
-        length++;
-        return pos;
+        size_t ind = pos - begin();
+        insert_at(ind, value);
+        return iterator(this, ind);
     }
     /**
      * inserts value at index ind.
@@ -434,16 +681,7 @@ class vector {
         if (ind > length) {
             throw index_out_of_bound();
         }
-        if (length == capacity) {
-            double_space();
-        }
-        for (size_t i = length; i > ind; --i) {
-            new (container + i) T(std::move(container[i - 1]));
-            container[i - 1].~T();
-        }
-
-        new (container + ind) T(value);
-        length++;
+        insert_at(ind, value);
         return iterator(this, ind);
     }
     /**
@@ -461,6 +699,7 @@ class vector {
         container[length - 1].~T();
 
         length--;
+        note_shape();
         return next;
     }
     /**
@@ -472,25 +711,20 @@ class vector {
         if (ind >= length) {
             throw index_out_of_bound();
         }
-        iterator pos = begin() + ind;
-
-        for (iterator i = pos; i < end() - 1; ++i) {
-            *i = std::move(*(i + 1));
+        for (size_t i = ind; i + 1 < length; ++i) {
+            container[i] = std::move(container[i + 1]);
         }
         container[length - 1].~T();
         length--;
+        note_shape();
 
-        return pos + 1;
+        return iterator(this, ind);
     }
     /**
      * adds an element to the end.
      */
     void push_back(const T &value) {
-        if (length == capacity) {
-            double_space();
-        }
-        new (container + length) T(value);
-        length++;
+        insert_at(length, value);
     }
     /**
      * remove the last element from the end.
@@ -500,28 +734,206 @@ class vector {
         if (length == 0) throw container_is_empty();
         container[length - 1].~T();
         length--;
+        note_shape();
     }
 
    private:
     size_t capacity;
     size_t length;
     T *container;
+    [[no_unique_address]] vector_detail::recorder telemetry;
+
+    /**
+     * raw storage for n elements aligned to Align. the plain operator new[]
+     * is kept whenever it already guarantees the requested alignment.
+     */
+    static T *allocate(size_t n) {
+        if constexpr (Align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return static_cast<T *>(
+                operator new[](n * sizeof(T), std::align_val_t(Align)));
+        } else {
+            return static_cast<T *>(operator new[](n * sizeof(T)));
+        }
+    }
+
+    static void deallocate(T *p) {
+        if constexpr (Align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            operator delete[](p, std::align_val_t(Align));
+        } else {
+            operator delete[](p);
+        }
+    }
+
+    /**
+     * allocate room for exactly n elements in an empty vector. the
+     * constructors that call it keep length up to date while they build, so
+     * fail() can undo a partial construction.
+     */
+    void reserve_exact(size_t n) {
+        if (n == 0) return;
+        container = allocate(n);
+        capacity = n;
+    }
 
-    void double_space() {
-        size_t new_capacity = (capacity == 0) ? 1 : capacity * 2;
-        T *new_container =
-            static_cast<T *>(operator new[](new_capacity * sizeof(T)));
-        for (size_t i = 0; i < capacity; ++i) {
-            new (new_container + i) T(std::move(container[i]));
+    /**
+     * a constructor threw after reserve_exact(): release what was built,
+     * since the destructor will not run.
+     */
+    void fail() {
+        for (size_t i = 0; i < length; ++i) {
             container[i].~T();
         }
+        deallocate(container);
+        container = nullptr;
+        capacity = 0;
+        length = 0;
+        note_shape();
+    }
+
+    template <class It>
+    void construct_from(It first, size_t n) {
+        reserve_exact(n);
+        try {
+            for (; length < n; ++length, ++first) {
+                new (container + length) T(*first);
+            }
+        } catch (...) {
+            fail();
+            throw;
+        }
+        telemetry.copied(n);
+        note_shape();
+    }
+
+    template <class It, class Sentinel>
+    void append_each(It first, Sentinel last) {
+        try {
+            for (; first != last; ++first) {
+                push_back(*first);
+            }
+        } catch (...) {
+            fail();
+            throw;
+        }
+    }
+
+    /**
+     * elements are relocated by move only when that cannot throw (or when T
+     * cannot be copied at all); otherwise they are copied, so the originals
+     * survive a failure. this is the rule of std::move_if_noexcept.
+     */
+    static constexpr bool relocate_by_move =
+        std::is_nothrow_move_constructible_v<T> ||
+        !std::is_copy_constructible_v<T>;
+
+    void count_relocation(size_t n) {
+        if (relocate_by_move) {
+            telemetry.moved(n);
+        } else {
+            telemetry.copied(n);
+        }
+    }
+
+    /**
+     * construct a copy of value at index ind, shifting [ind, length) up.
+     * strong exception guarantee: if anything throws, the vector is
+     * unchanged. value may refer to an element of this vector.
+     */
+    void insert_at(size_t ind, const T &value) {
+        if (length < capacity && ind == length) {
+            new (container + length) T(value);
+            telemetry.copied(1);
+        } else if (length < capacity && relocate_by_move) {
+            // copy first: it may throw, and value may alias a shifted slot
+            T copy(value);
+            telemetry.copied(1);
+            for (size_t i = length; i > ind; --i) {
+                new (container + i) T(std::move(container[i - 1]));
+                container[i - 1].~T();
+            }
+            new (container + ind) T(std::move(copy));
+            telemetry.moved(length - ind + 1);
+        } else {
+            // out of room, or shifting in place could throw half-way
+            size_t new_capacity = length < capacity ? capacity
+                                  : capacity == 0   ? 1
+                                                    : capacity * 2;
+            relocate_insert(new_capacity, ind, value);
+        }
+        length++;
+        note_shape();
+    }
+
+    /**
+     * move this vector into fresh storage of new_capacity elements with a
+     * copy of value constructed at index ind. the old storage is released
+     * only once every element made it across; a throwing copy destroys what
+     * was built and leaves the vector as it was.
+     */
+    void relocate_insert(size_t new_capacity, size_t ind, const T &value) {
+        T *fresh = allocate(new_capacity);
+        try {
+            new (fresh + ind) T(value);
+        } catch (...) {
+            deallocate(fresh);
+            throw;
+        }
+        size_t built = 0;
+        try {
+            for (; built < length; ++built) {
+                new (fresh + built + (built >= ind))
+                    T(std::move_if_noexcept(container[built]));
+            }
+        } catch (...) {
+            for (size_t i = 0; i < built; ++i) {
+                fresh[i + (i >= ind)].~T();
+            }
+            fresh[ind].~T();
+            deallocate(fresh);
+            throw;
+        }
+        telemetry.copied(1);
+        telemetry.relocated(length * sizeof(T));
+        count_relocation(length);
 
-        operator delete[](container);
-        container = new_container;
+        for (size_t i = 0; i < length; ++i) {
+            container[i].~T();
+        }
+        deallocate(container);
+        container = fresh;
         capacity = new_capacity;
     }
+
+    void note_shape() {
+        telemetry.reshaped(capacity * sizeof(T), length * sizeof(T));
+    }
 };
 
+/**
+ * wraps a T so that it occupies a cache line of its own.
+ * use padded_vector for per-core slots (counters, queues) that are written
+ * from different threads: neighbouring slots never share a line, so there is
+ * no false sharing between them.
+ */
+template <typename T, size_t Line = cache_line_size>
+struct alignas(Line) padded {
+    T value;
+
+    padded() : value() {
+    }
+    padded(const T &value) : value(value) {
+    }
+    operator T &() {
+        return value;
+    }
+    operator const T &() const {
+        return value;
+    }
+};
+
+template <typename T, size_t Line = cache_line_size>
+using padded_vector = vector<padded<T, Line>, Line>;
+
 }  // namespace sjtu
 
 #endif
\ No newline at end of file